@@ -0,0 +1,544 @@
+#include "Jogo.h"
+#include "Bitmap.h"
+#include "Arena.h"
+#include "Pixels.h"
+#include "Font.h"
+#include "str8.h"
+
+using namespace Jogo;
+
+// times each version of the pixel kernels over a range of rect sizes, in GB/s written
+// every kernel is checked against the scalar one first, a wrong answer fast is no use
+
+typedef void (*FillRowKernel)(u32* Row, u32 Color, size_t Count, bool Stream);
+
+struct FillKernel
+{
+	const char* Name;
+	FillRowKernel Fill;
+	Pixels::Level Needs;
+};
+
+static const FillKernel FillKernels[] =
+{
+	{ "scalar", Pixels::FillRow32Scalar, Pixels::LEVEL_SCALAR },
+	{ "sse2", Pixels::FillRow32SSE2, Pixels::LEVEL_SSE2 },
+	{ "avx2", Pixels::FillRow32AVX2, Pixels::LEVEL_AVX2 },
+};
+
+static void FillWith(Bitmap& Target, Bitmap::Rect r, u32 Color, FillRowKernel Fill, bool Stream)
+{
+	for (s32 i = 0; i < r.h; i++)
+	{
+		Fill(Target.GetRowBGRA(r.y + i) + r.x, Color, (size_t)r.w, Stream);
+	}
+	if (Stream)
+	{
+		Pixels::EndStream();
+	}
+}
+
+static bool CheckFill(Bitmap& Target, const FillKernel& Kernel, Arena& arena)
+{
+	// odd offsets and widths so the head and tail paths are all hit
+	for (s32 x = 0; x < 9; x++)
+	{
+		for (s32 w = 0; w < 80; w++)
+		{
+			for (u32 Stream = 0; Stream < 2; Stream++)
+			{
+				Bitmap::Rect r = { x, 1, w, 2 };
+				Target.Erase(0x11111111);
+				FillWith(Target, r, 0xdeadbeef, Kernel.Fill, Stream != 0);
+				for (s32 y = 0; y < 4; y++)
+				{
+					for (s32 i = 0; i < 100; i++)
+					{
+						bool Inside = y >= r.y && y < r.y + r.h && i >= r.x && i < r.x + r.w;
+						if (Target.GetRowBGRA(y)[i] != (Inside ? 0xdeadbeef : 0x11111111))
+						{
+							Printf(arena, "{} fill wrong at x {} w {} stream {}\n", Kernel.Name, x, w, Stream);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void BenchFill(Bitmap& Target, Arena& arena)
+{
+	static const s32 Sizes[] = { 16, 64, 256, 512, 1024, 2048 };
+	static const size_t BytesPerTest = 512 * 1024 * 1024;
+
+	Print("FillRect GB/s, rect size down, kernel across\n");
+	Print("            scalar    sse2  stream    avx2  stream\n");
+	Timer timer;
+	for (s32 Size : Sizes)
+	{
+		size_t RectBytes = (size_t)Size * Size * 4;
+		u32 Repeats = (u32)(BytesPerTest / RectBytes);
+		str8 Line = str8::format(arena, "{:4}x{:4}  ", Size, Size);
+		for (const FillKernel& Kernel : FillKernels)
+		{
+			for (u32 Stream = 0; Stream < 2; Stream++)
+			{
+				if (Kernel.Needs == Pixels::LEVEL_SCALAR && Stream)
+					continue;
+				if (Kernel.Needs > Pixels::GetLevel())
+				{
+					Line = str8::format(arena, "{}{:8}", Line, "-");
+					continue;
+				}
+
+				// walk the rect around the bitmap so a small one isn't always hitting the same lines
+				timer.Start();
+				for (u32 i = 0; i < Repeats; i++)
+				{
+					Bitmap::Rect r = { (s32)((i * 4) % (Target.Width - Size + 1)), (s32)((i * 7) % (Target.Height - Size + 1)), Size, Size };
+					FillWith(Target, r, i, Kernel.Fill, Stream != 0);
+				}
+				double Seconds = timer.GetSecondsSinceLast();
+				Line = str8::format(arena, "{}{:8.2}", Line, (f32)((double)Repeats * RectBytes / Seconds / 1e9));
+			}
+		}
+		Print(str8::format(arena, "{}\n", Line));
+	}
+}
+
+typedef void (*ExpandRowKernel)(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque);
+
+struct ExpandKernel
+{
+	const char* Name;
+	ExpandRowKernel Expand;
+	Pixels::Level Needs;
+};
+
+static const ExpandKernel ExpandKernels[] =
+{
+	{ "scalar", Pixels::ExpandMask32Scalar, Pixels::LEVEL_SCALAR },
+	{ "sse2", Pixels::ExpandMask32SSE2, Pixels::LEVEL_SSE2 },
+	{ "avx2", Pixels::ExpandMask32AVX2, Pixels::LEVEL_AVX2 },
+};
+
+static bool CheckExpand(const ExpandKernel& Kernel, Bitmap& Mask, Arena& arena)
+{
+	u32 Expected[80];
+	u32 Got[80];
+	for (s32 x = 0; x < 9; x++)
+	{
+		for (s32 w = 0; w < 70; w++)
+		{
+			for (u32 Opaque = 0; Opaque < 2; Opaque++)
+			{
+				for (u32 i = 0; i < 80; i++)
+				{
+					Expected[i] = Got[i] = 0x11111111 * (i & 15);
+				}
+				Pixels::ExpandMask32Scalar(Expected + x, Mask.PixelA + x, (size_t)w, 0xdeadbeef, 0xff203040, Opaque != 0);
+				Kernel.Expand(Got + x, Mask.PixelA + x, (size_t)w, 0xdeadbeef, 0xff203040, Opaque != 0);
+				if (memcmp(Expected, Got, sizeof(Got)))
+				{
+					Printf(arena, "{} expand wrong at x {} w {} opaque {}\n", Kernel.Name, x, w, Opaque);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void BenchExpand(Bitmap& Target, Bitmap& Mask, Arena& arena)
+{
+	static const s32 Sizes[] = { 8, 16, 64, 256, 1024 };
+	static const size_t BytesPerTest = 256 * 1024 * 1024;
+
+	Print("8bpp mask to 32bpp GB/s written, opaque then transparent\n");
+	Print("            scalar    sse2    avx2  scalar    sse2    avx2\n");
+	Timer timer;
+	for (s32 Size : Sizes)
+	{
+		size_t RectBytes = (size_t)Size * Size * 4;
+		u32 Repeats = (u32)(BytesPerTest / RectBytes);
+		str8 Line = str8::format(arena, "{:4}x{:4}  ", Size, Size);
+		for (u32 Opaque = 2; Opaque-- > 0;)
+		{
+			for (const ExpandKernel& Kernel : ExpandKernels)
+			{
+				if (Kernel.Needs > Pixels::GetLevel())
+				{
+					Line = str8::format(arena, "{}{:8}", Line, "-");
+					continue;
+				}
+
+				timer.Start();
+				for (u32 i = 0; i < Repeats; i++)
+				{
+					s32 x = (s32)((i * 4) % (Target.Width - Size + 1));
+					s32 y = (s32)((i * 7) % (Target.Height - Size + 1));
+					for (s32 Row = 0; Row < Size; Row++)
+					{
+						Kernel.Expand(Target.GetRowBGRA(y + Row) + x, Mask.GetRow(y + Row) + x, (size_t)Size, i, 0xff000000, Opaque != 0);
+					}
+				}
+				double Seconds = timer.GetSecondsSinceLast();
+				Line = str8::format(arena, "{}{:8.2}", Line, (f32)((double)Repeats * RectBytes / Seconds / 1e9));
+			}
+		}
+		Print(str8::format(arena, "{}\n", Line));
+	}
+}
+
+static void BenchScale(Bitmap& Target, Bitmap& Mask, Arena& arena)
+{
+	// scale as a fraction, the source rect's side down and the dest's up
+	static const s32 Scales[][2] = { { 1, 2 }, { 1, 3 }, { 1, 4 }, { 2, 3 }, { 3, 2 }, { 1, 25 } };
+	static const size_t BytesPerTest = 256 * 1024 * 1024;
+	static const Pixels::Level Levels[] = { Pixels::LEVEL_SCALAR, Pixels::LEVEL_SSE2, Pixels::LEVEL_AVX2 };
+
+	Bitmap Source = Bitmap::Create(256, 256, 4, arena);
+	for (u32 i = 0; i < Source.Width * Source.Height; i++)
+	{
+		Source.PixelBGRA[i] = i * 2654435761u;
+	}
+
+	Print("PasteBitmapSelectionScaled GB/s written to a 960x960 rect, 32bpp then 8bpp transparent\n");
+	Print("            scalar    sse2    avx2  scalar    sse2    avx2\n");
+	Pixels::Level Widest = Pixels::GetLevel();
+	Timer timer;
+	for (const s32* Scale : Scales)
+	{
+		s32 DestSize = 960;
+		s32 SourceSize = DestSize * Scale[0] / Scale[1];
+		size_t RectBytes = (size_t)DestSize * DestSize * 4;
+		u32 Repeats = (u32)(BytesPerTest / RectBytes);
+		str8 Line = str8::format(arena, "{:4}/{:<4}   ", Scale[1], Scale[0]);
+		for (u32 Format = 0; Format < 2; Format++)
+		{
+			Bitmap& From = Format ? Mask : Source;
+			for (Pixels::Level Level : Levels)
+			{
+				if (Level > Widest)
+				{
+					Line = str8::format(arena, "{}{:8}", Line, "-");
+					continue;
+				}
+
+				Pixels::SetLevel(Level);
+				timer.Start();
+				for (u32 i = 0; i < Repeats; i++)
+				{
+					Target.PasteBitmapSelectionScaled({ 0, 0, DestSize, DestSize }, From, { (s32)(i & 63), 0, SourceSize, SourceSize }, 0xffffff, 0);
+				}
+				double Seconds = timer.GetSecondsSinceLast();
+				Line = str8::format(arena, "{}{:8.2}", Line, (f32)((double)Repeats * RectBytes / Seconds / 1e9));
+			}
+		}
+		Print(str8::format(arena, "{}\n", Line));
+	}
+	Pixels::SetLevel(Widest);
+}
+
+struct BlendKernel
+{
+	const char* Name;
+	void (*Over)(u32* Row, const u32* Source, size_t Count);
+	void (*Add)(u32* Row, const u32* Source, size_t Count);
+	void (*Key)(u32* Row, const u32* Source, size_t Count, u32 Key);
+	void (*Coverage)(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add);
+	Pixels::Level Needs;
+};
+
+static const BlendKernel BlendKernels[] =
+{
+	{ "scalar", Pixels::BlendOver32Scalar, Pixels::BlendAdd32Scalar, Pixels::ColorKey32Scalar, Pixels::BlendCoverage32Scalar, Pixels::LEVEL_SCALAR },
+	{ "sse2", Pixels::BlendOver32SSE2, Pixels::BlendAdd32SSE2, Pixels::ColorKey32SSE2, Pixels::BlendCoverage32SSE2, Pixels::LEVEL_SSE2 },
+	{ "avx2", Pixels::BlendOver32AVX2, Pixels::BlendAdd32AVX2, Pixels::ColorKey32AVX2, Pixels::BlendCoverage32AVX2, Pixels::LEVEL_AVX2 },
+};
+
+static const u32 BlendOps = 5;
+static const char* BlendOpNames[BlendOps] = { "over", "add", "color key", "coverage over", "coverage add" };
+
+static void BlendWith(const BlendKernel& Kernel, u32 Op, u32* Row, const u32* Source, const u8* Coverage, size_t Count)
+{
+	switch (Op)
+	{
+	case 0: Kernel.Over(Row, Source, Count); break;
+	case 1: Kernel.Add(Row, Source, Count); break;
+	case 2: Kernel.Key(Row, Source, Count, 0xff00ff00); break;
+	default: Kernel.Coverage(Row, Coverage, Count, 0x80c0ff, Op == 4); break;
+	}
+}
+
+static bool CheckBlend(const BlendKernel& Kernel, const u32* Source, const u8* Coverage, Arena& arena)
+{
+	u32 Expected[80];
+	u32 Got[80];
+	for (u32 Op = 0; Op < BlendOps; Op++)
+	{
+		for (s32 x = 0; x < 9; x++)
+		{
+			for (s32 w = 0; w < 70; w++)
+			{
+				for (u32 i = 0; i < 80; i++)
+				{
+					Expected[i] = Got[i] = Source[i + 1000] ^ 0x5a5a5a5a;
+				}
+				BlendWith(BlendKernels[0], Op, Expected + x, Source + x, Coverage + x, (size_t)w);
+				BlendWith(Kernel, Op, Got + x, Source + x, Coverage + x, (size_t)w);
+				if (memcmp(Expected, Got, sizeof(Got)))
+				{
+					Printf(arena, "{} {} wrong at x {} w {}\n", Kernel.Name, BlendOpNames[Op], x, w);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void BenchBlend(Bitmap& Target, const u32* Source, const u8* Coverage, Arena& arena)
+{
+	static const s32 Size = 256;
+	static const size_t BytesPerTest = 256 * 1024 * 1024;
+
+	Print("blends GB/s written to a 256x256 rect\n");
+	Print("                  scalar    sse2    avx2\n");
+	Timer timer;
+	size_t RectBytes = (size_t)Size * Size * 4;
+	u32 Repeats = (u32)(BytesPerTest / RectBytes);
+	for (u32 Op = 0; Op < BlendOps; Op++)
+	{
+		str8 Line = str8::format(arena, "{:<16}", BlendOpNames[Op]);
+		for (const BlendKernel& Kernel : BlendKernels)
+		{
+			if (Kernel.Needs > Pixels::GetLevel())
+			{
+				Line = str8::format(arena, "{}{:8}", Line, "-");
+				continue;
+			}
+
+			timer.Start();
+			for (u32 i = 0; i < Repeats; i++)
+			{
+				s32 x = (s32)((i * 4) % (Target.Width - Size + 1));
+				s32 y = (s32)((i * 7) % (Target.Height - Size + 1));
+				for (s32 Row = 0; Row < Size; Row++)
+				{
+					BlendWith(Kernel, Op, Target.GetRowBGRA(y + Row) + x, Source + Row * Size, Coverage + Row * Size, (size_t)Size);
+				}
+			}
+			double Seconds = timer.GetSecondsSinceLast();
+			Line = str8::format(arena, "{}{:8.2}", Line, (f32)((double)Repeats * RectBytes / Seconds / 1e9));
+		}
+		Print(str8::format(arena, "{}\n", Line));
+	}
+}
+
+static void BenchText(Bitmap& Target, Font& MaskFont, Arena& arena)
+{
+	static const u32 Lines = 100000;
+	static const char* Sentence = "The quick brown fox jumps over the lazy dog";
+
+	// the antialiased copy has every set texel at full coverage and its clear neighbours across at a quarter,
+	// so the blend sees edges like a rasterised font's
+	Font SoftFont = MaskFont;
+	SoftFont.Antialiased = true;
+	SoftFont.FontBitmap = Bitmap::Create(MaskFont.FontBitmap.Width, MaskFont.FontBitmap.Height, 1, arena);
+	for (u32 y = 0; y < MaskFont.FontBitmap.Height; y++)
+	{
+		const u8* Mask = MaskFont.FontBitmap.GetRow((s32)y);
+		u8* Coverage = SoftFont.FontBitmap.GetRow((s32)y);
+		for (u32 x = 0; x < MaskFont.FontBitmap.Width; x++)
+		{
+			bool Edge = (x > 0 && Mask[x - 1]) || (x + 1 < MaskFont.FontBitmap.Width && Mask[x + 1]);
+			Coverage[x] = Mask[x] ? 255 : Edge ? 64 : 0;
+		}
+	}
+
+	Print("DrawText Mglyphs/s, unscaled on a clear background\n");
+	str8 Text(Sentence, str8::cstringlength(Sentence));
+	s32 TextWidth = (s32)(Text.len * MaskFont.CharacterWidth);
+	s32 TextHeight = (s32)MaskFont.CharacterHeight;
+	Font* Fonts[] = { &MaskFont, &SoftFont };
+	const char* FontNames[] = { "mask", "antialiased" };
+	Timer timer;
+	for (u32 f = 0; f < 2; f++)
+	{
+		timer.Start();
+		for (u32 i = 0; i < Lines; i++)
+		{
+			s32 x = (s32)((i * 4) % (Target.Width - TextWidth + 1));
+			s32 y = (s32)((i * 7) % (Target.Height - TextHeight + 1));
+			Fonts[f]->DrawText(x, y, Text, 0xffffffff, 0, Target);
+		}
+		double Seconds = timer.GetSecondsSinceLast();
+		Printf(arena, "{:<16}{:8.2}\n", FontNames[f], (f32)((double)Lines * Text.len / Seconds / 1e6));
+	}
+}
+
+static bool CheckExpand24(const u8* Source, Arena& arena)
+{
+	if (!GetCPUFeatures().SSSE3)
+		return true;
+
+	u32 Expected[80];
+	u32 Got[80];
+	for (s32 x = 0; x < 9; x++)
+	{
+		for (s32 w = 0; w < 70; w++)
+		{
+			memset(Expected, 0x11, sizeof(Expected));
+			memset(Got, 0x11, sizeof(Got));
+			Pixels::Expand24To32Scalar(Expected + x, Source + x, (size_t)w);
+			Pixels::Expand24To32SSSE3(Got + x, Source + x, (size_t)w);
+			if (memcmp(Expected, Got, sizeof(Got)))
+			{
+				Printf(arena, "ssse3 24 to 32 wrong at x {} w {}\n", x, w);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+struct ReplicateKernel
+{
+	const char* Name;
+	void (*Replicate)(u32* Row, const u32* Source, size_t Count, u32 Factor);
+	Pixels::Level Needs;
+};
+
+static const ReplicateKernel ReplicateKernels[] =
+{
+	{ "sse2", Pixels::ReplicateRow32SSE2, Pixels::LEVEL_SSE2 },
+	{ "avx2", Pixels::ReplicateRow32AVX2, Pixels::LEVEL_AVX2 },
+};
+
+// the integer factors and the 16.16 stepping BenchScale times, against their scalar loops; steps up and down,
+// each starting partway into a source pixel
+static bool CheckScale(const u32* Source, Arena& arena)
+{
+	u32 Expected[300];
+	u32 Got[300];
+	for (const ReplicateKernel& Kernel : ReplicateKernels)
+	{
+		if (Kernel.Needs > Pixels::GetLevel())
+			continue;
+
+		for (s32 x = 0; x < 9; x++)
+		{
+			for (s32 w = 0; w < 70; w++)
+			{
+				for (u32 Factor = 2; Factor <= Pixels::MaxReplicate; Factor++)
+				{
+					memset(Expected, 0x11, sizeof(Expected));
+					memset(Got, 0x11, sizeof(Got));
+					Pixels::ReplicateRow32Scalar(Expected + x, Source + x, (size_t)w, Factor);
+					Kernel.Replicate(Got + x, Source + x, (size_t)w, Factor);
+					if (memcmp(Expected, Got, sizeof(Got)))
+					{
+						Printf(arena, "{} replicate wrong at x {} w {} factor {}\n", Kernel.Name, x, w, Factor);
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	if (Pixels::GetLevel() < Pixels::LEVEL_AVX2)
+		return true;
+
+	static const u32 Steps[] = { 0x4000, 0x5555, 0x8000, 0xaaaa, 0x10000, 0x18000, 0x30000 };
+	static const u32 Starts[] = { 0, 0x1234, 0x8000, 0xffff, 0x2a000 };
+	for (u32 dx : Steps)
+	{
+		for (u32 Start : Starts)
+		{
+			for (s32 w = 0; w < 70; w++)
+			{
+				memset(Expected, 0x11, sizeof(Expected));
+				memset(Got, 0x11, sizeof(Got));
+				Pixels::ScaleRow32Scalar(Expected + 1, Source, (size_t)w, Start, dx);
+				Pixels::ScaleRow32AVX2(Got + 1, Source, (size_t)w, Start, dx);
+				if (memcmp(Expected, Got, sizeof(Got)))
+				{
+					Printf(arena, "avx2 scale wrong at w {} start {} step {}\n", w, Start, dx);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	Arena arena = Arena::CreateGrowable();
+	Bitmap Target = Bitmap::Create(2048, 2048, 4, arena);
+
+	Printf(arena, "widest kernels: {}\n", Pixels::GetLevel() == Pixels::LEVEL_AVX2 ? "avx2" : Pixels::GetLevel() == Pixels::LEVEL_SSE2 ? "sse2" : "scalar");
+	for (const FillKernel& Kernel : FillKernels)
+	{
+		if (Kernel.Needs <= Pixels::GetLevel() && !CheckFill(Target, Kernel, arena))
+			return 1;
+	}
+
+	// a glyph-like mask, runs of set and clear bytes rather than noise
+	Bitmap Mask = Bitmap::Create(2048, 2048, 1, arena);
+	Random Rand = { 12345 };
+	for (u32 i = 0; i < Mask.Width * Mask.Height; i++)
+	{
+		Mask.PixelA[i] = (Rand.GetNext() & 3) ? Mask.PixelA[i ? i - 1 : 0] : (u8)(Rand.GetNext() & 1);
+	}
+	for (const ExpandKernel& Kernel : ExpandKernels)
+	{
+		if (Kernel.Needs <= Pixels::GetLevel() && !CheckExpand(Kernel, Mask, arena))
+			return 1;
+	}
+
+	// premultiplied sprite pixels with every alpha, some of them the key, and a coverage ramp
+	u32* Sprite = (u32*)arena.Allocate(256 * 256 * sizeof(u32));
+	u8* Coverage = (u8*)arena.Allocate(256 * 256);
+	for (u32 i = 0; i < 256 * 256; i++)
+	{
+		u32 Alpha = Rand.GetNext() & 0xff;
+		u32 Pixel = Alpha << 24;
+		for (u32 Shift = 0; Shift < 24; Shift += 8)
+		{
+			Pixel |= ((Rand.GetNext() & 0xff) * Alpha / 255) << Shift;
+		}
+		Sprite[i] = (Rand.GetNext() & 7) ? Pixel : 0xff00ff00;
+		Coverage[i] = (u8)(i * 7 + (i >> 8));
+	}
+	for (const BlendKernel& Kernel : BlendKernels)
+	{
+		if (Kernel.Needs <= Pixels::GetLevel() && !CheckBlend(Kernel, Sprite, Coverage, arena))
+			return 1;
+	}
+
+	if (!CheckExpand24(Coverage, arena))
+		return 1;
+	if (!CheckScale(Sprite, arena))
+		return 1;
+
+	BenchFill(Target, arena);
+	BenchExpand(Target, Mask, arena);
+	BenchScale(Target, Mask, arena);
+	BenchBlend(Target, Sprite, Coverage, arena);
+
+	// run from BlitBench's directory, like the apps, to find the font
+	Font TextFont = Font::Load("../Jogo/Font16.fnt", arena);
+	if (TextFont.FontBitmap.Pixels)
+	{
+		BenchText(Target, TextFont, arena);
+	}
+	else
+	{
+		Print("no ../Jogo/Font16.fnt, skipping DrawText\n");
+	}
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include "Jogo.h"
+#include "Array.h"
+#include "HashMap.h"
+#include "Intern.h"
+#include <stdio.h>
+
+using namespace Jogo;
+
+// Array, HashMap and Interner against what they promise, prints each failure and returns 1 if there were any
+
+static u32 Failures = 0;
+
+static void Check(bool Passed, const char* What, u32 Detail = 0)
+{
+	if (!Passed)
+	{
+		printf("FAILED: %s (%u)\n", What, Detail);
+		Failures++;
+	}
+}
+
+static void TestArray(Arena& arena)
+{
+	Array<u32> Values = Array<u32>::Create(arena, 4);
+	for (u32 i = 0; i < 10000; i++)
+	{
+		Check(Values.Add(i * 3), "Array Add");
+	}
+	Check(Values.Count == 10000, "Array Count", Values.Count);
+	Check(Values.Capacity >= 10000 && Values.Capacity < 20000 * 2, "Array doubles", Values.Capacity);
+	bool InOrder = true;
+	for (u32 i = 0; i < Values.Count; i++)
+	{
+		InOrder = InOrder && Values[i] == i * 3;
+	}
+	Check(InOrder, "Array keeps its elements across growth");
+
+	// alone on top of the arena it grows in place, doubling from 16 to 1024 copies nothing
+	Arena Fresh = Arena::CreateGrowable();
+	Array<u64> Top = Array<u64>::Create(Fresh);
+	u64* First = Top.Data;
+	for (u64 i = 0; i < 1024; i++)
+	{
+		Top.Add(i);
+	}
+	Check(Top.Data == First, "Array grows in place on top of the arena");
+	Check((size_t)(Fresh.CurrentLocation - Fresh.BaseAddress) == 1024 * sizeof(u64), "Array in place uses no extra memory",
+		(u32)(Fresh.CurrentLocation - Fresh.BaseAddress));
+	Fresh.ReleaseMemory();
+
+	Values.Remove(0);
+	Check(Values.Count == 9999 && Values[0] == 3 && Values[9998] == 9999 * 3, "Array Remove keeps order");
+	Values.RemoveSwap(0);
+	Check(Values.Count == 9998 && Values[0] == 9999 * 3, "Array RemoveSwap moves the last in");
+	Check(Values.Pop() == 9998 * 3, "Array Pop");
+}
+
+static void TestHashMap(Arena& arena)
+{
+	// grows from 16 several times on the way
+	HashMap<u64, u32> Map = HashMap<u64, u32>::Create(arena);
+	const u32 Count = 5000;
+	for (u32 i = 0; i < Count; i++)
+	{
+		Check(Map.Insert((u64)i * 7919, i), "HashMap Insert");
+	}
+	Check(Map.Count == Count, "HashMap Count", Map.Count);
+	Check(Map.Count * 4 <= Map.Capacity * 3, "HashMap stays under 3/4 full", Map.Capacity);
+
+	bool Added = true;
+	u32* Existing = Map.FindOrAdd(7919 * 10, &Added);
+	Check(Existing && *Existing == 10 && !Added, "HashMap FindOrAdd finds");
+	Check(!Map.Find(3), "HashMap Find misses");
+
+	// every other key out, each removal has to pull back the probe run behind it
+	for (u32 i = 0; i < Count; i += 2)
+	{
+		Check(Map.Remove((u64)i * 7919), "HashMap Remove", i);
+	}
+	Check(!Map.Remove(0), "HashMap Remove of a missing key");
+	Check(Map.Count == Count / 2, "HashMap Count after Remove", Map.Count);
+	for (u32 i = 0; i < Count; i++)
+	{
+		u32* Value = Map.Find((u64)i * 7919);
+		if (i & 1)
+		{
+			Check(Value && *Value == i, "HashMap keeps what wasn't removed", i);
+		}
+		else
+		{
+			Check(!Value, "HashMap forgets what was removed", i);
+		}
+	}
+
+	// a run that wraps past the end of the table, all in slot 15's run
+	HashMap<u64, u32> Small = HashMap<u64, u32>::Create(arena);
+	u64 Colliding[4];
+	u32 Found = 0;
+	for (u64 Key = 1; Found < 4; Key++)
+	{
+		if ((HashKey(Key) & 15) == 15)
+		{
+			Colliding[Found++] = Key;
+		}
+	}
+	for (u32 i = 0; i < 4; i++)
+	{
+		Small.Insert(Colliding[i], i);
+	}
+	Small.Remove(Colliding[0]);
+	for (u32 i = 1; i < 4; i++)
+	{
+		u32* Value = Small.Find(Colliding[i]);
+		Check(Value && *Value == i, "HashMap Remove shifts back across the wrap", i);
+	}
+
+	HashMap<str8, u32> Names = HashMap<str8, u32>::Create(arena);
+	Names.Insert(str8("one"), 1);
+	Names.Insert(str8("two"), 2);
+	u32* Two = Names.Find(str8("two"));
+	Check(Two && *Two == 2, "HashMap str8 keys");
+	Check(!Names.Find(str8("three")), "HashMap str8 miss");
+}
+
+static void TestInterner()
+{
+	Arena arena = Arena::CreateGrowable();
+	Interner Names = Interner::Create(arena, 16);
+	const u32 Count = 20000;
+	char Name[32];
+	for (u32 i = 0; i < Count; i++)
+	{
+		int Length = snprintf(Name, sizeof(Name), "name%u", i);
+		Check(Names.GetID(str8(Name, (size_t)Length)) == i, "Interner IDs count up", i);
+	}
+	Check(Names.Strings.Count == Count, "Interner Count", Names.Strings.Count);
+
+	// the same characters from somewhere else give the same ID and the same copy
+	bool SameIDs = true;
+	for (u32 i = 0; i < Count; i += 97)
+	{
+		int Length = snprintf(Name, sizeof(Name), "name%u", i);
+		str8 Again(Name, (size_t)Length);
+		SameIDs = SameIDs && Names.GetID(Again) == i && Names.Intern(Again).chars == Names.GetString(i).chars;
+	}
+	Check(SameIDs, "Interner finds what it has");
+	Check(Names.Strings.Count == Count, "Interner adds nothing for a repeat", Names.Strings.Count);
+	Check(Names.GetString(42).chars[Names.GetString(42).len] == 0, "Interner copies are null terminated");
+
+	// the ID array doubles, so 20000 names is a few MB, growing it a slot at a time was gigabytes
+	size_t Used = (size_t)(arena.CurrentLocation - arena.BaseAddress);
+	Check(Used < 8 * 1024 * 1024, "Interner memory is linear in the names", (u32)(Used / 1024));
+	arena.ReleaseMemory();
+}
+
+int main(int argc, char* argv[])
+{
+	Arena arena = Arena::CreateGrowable();
+	TestArray(arena);
+	TestHashMap(arena);
+	TestInterner();
+	arena.ReleaseMemory();
+
+	printf("%s\n", Failures ? "container tests failed" : "container tests passed");
+	return Failures ? 1 : 0;
+}
@@ -159,7 +159,7 @@ public:
 			// based on setting, draw curves between points
 		}
 		DrawParametricCurve();
-		Jogo::Show(BackBuffer.PixelBGRA, Width, Height);
+		Jogo::Show(BackBuffer);
 	}
 };
 const char* Curves::Name = "Curves";
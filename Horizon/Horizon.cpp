@@ -47,12 +47,15 @@ class Horizon : public Jogo::App
 public:
 	Horizon()
 	{
-		HorizonArena = Arena::Create(DefaultArenaSize);
-		AtariFont = Font::Load("../Jogo/Atari8.fnt", HorizonArena);
+		HorizonArena = Arena::CreateGrowable();
+#if JOGO_PROFILE
+		MemoryReport::Track(HorizonArena, "HorizonArena");
+#endif
+		AtariFont = Assets.LoadFont("../Jogo/Atari8.fnt", HorizonArena);
 		F = Bitmap::Create(8, 8, 1, HorizonArena);
 		F.Erase(0xffffff);
 		F.PasteBitmapSelection(0, 0, AtariFont.FontBitmap, { 48, 8, 8, 8 }, 0);
-		Texture = Bitmap::Load("checker.bmp", HorizonArena);
+		Texture = Assets.LoadBitmap("checker.bmp", HorizonArena);
 		Solids[0] = CreateCube();
 		Solids[1] = CreateTetra();
 		Solids[2] = CreateOcta();
@@ -485,8 +488,12 @@ public:
 		theta += dtheta;
 		double frametimeseconds = frametime.GetSecondsSinceLast();
 		AtariFont.DrawText(0, 40, str8::format(FrameArena, "{:}", (float)frametimeseconds), 0, 0, BackBuffer);
+#if JOGO_PROFILE
+		Profiler::DrawOverlay(BackBuffer, AtariFont, 0, 60, FrameArena);
+		MemoryReport::DrawOverlay(BackBuffer, AtariFont, 500, 0, FrameArena);
+#endif
 
-		Show(BackBuffer.PixelBGRA, BackBuffer.Width, BackBuffer.Height);
+		Show(BackBuffer);
 		FrameArena.Clear();
 	}
 };
@@ -0,0 +1,233 @@
+#include "Jogo.h"
+#include "Jobs.h"
+#include <stdio.h>
+
+using namespace Jogo;
+
+// the job system under load: the work-stealing deques, nested ParallelFor, dependency counters and submits
+// from a thread outside the pool; prints each failure and returns 1 if there were any
+
+static u32 Failures = 0;
+
+static void Check(bool Passed, const char* What, u32 Detail = 0)
+{
+	if (!Passed)
+	{
+		printf("FAILED: %s (%u)\n", What, Detail);
+		Failures++;
+	}
+}
+
+static const u32 Count = 100000;
+static volatile s32 Hits[Count];
+static const u32 MaxCounted = 64;
+static volatile s32 RanOn[MaxCounted];
+
+static void MarkRange(void* Data, u32 Begin, u32 End)
+{
+	for (u32 i = Begin; i < End; i++)
+	{
+		AtomicAdd(&Hits[i], 1);
+	}
+	AtomicAdd(&RanOn[Jobs::GetWorkerIndex() % MaxCounted], 1);
+}
+
+static bool EveryIndexOnce(u32 Expected)
+{
+	bool Once = true;
+	for (u32 i = 0; i < Count; i++)
+	{
+		Once = Once && Hits[i] == (s32)Expected;
+	}
+	return Once;
+}
+
+static void ClearHits()
+{
+	for (u32 i = 0; i < Count; i++)
+	{
+		Hits[i] = 0;
+	}
+	for (u32 i = 0; i < MaxCounted; i++)
+	{
+		RanOn[i] = 0;
+	}
+}
+
+static bool Stolen()
+{
+	for (u32 i = 1; i < Jobs::GetWorkerCount() && i < MaxCounted; i++)
+	{
+		if (RanOn[i])
+			return true;
+	}
+	return false;
+}
+
+// on the main thread, gives the workers up to a second to steal something, so one core is enough to see it
+static void HoldForThief(void* Data, u32 Begin, u32 End)
+{
+	Timer Held;
+	double Seconds = 0;
+	while (Jobs::GetWorkerIndex() == 0 && Jobs::GetWorkerCount() > 1 && !Stolen() && Seconds < 1.0)
+	{
+		SleepSeconds(0.001);
+		Seconds += Held.GetSecondsSinceLast();
+	}
+}
+
+// every job is pushed by the main thread, so anything another worker runs it stole
+static void TestSubmitAndSteal()
+{
+	ClearHits();
+	Jobs::Counter Done = {};
+	for (u32 i = 0; i < Count; i += 100)
+	{
+		Jobs::SubmitRange(MarkRange, nullptr, i, i + 100, &Done);
+	}
+
+	// the owner pops from the end it pushes to, so this runs first
+	Jobs::Submit(HoldForThief, nullptr, &Done);
+	Jobs::Wait(&Done);
+	Check(Done.Value == 0, "Counter back to 0", (u32)Done.Value);
+	Check(EveryIndexOnce(1), "SubmitRange runs every index once");
+
+	Check(Jobs::GetWorkerCount() < 2 || Stolen(), "other workers steal from the main thread's queue");
+}
+
+// each outer batch runs its own ParallelFor from whichever worker it landed on
+static void InnerFor(void* Data, u32 Begin, u32 End)
+{
+	u32 Outer = (u32)(size_t)Data;
+	for (u32 i = Begin; i < End; i++)
+	{
+		AtomicAdd(&Hits[Outer * 1000 + i], 1);
+	}
+}
+
+static void OuterFor(void* Data, u32 Begin, u32 End)
+{
+	for (u32 Outer = Begin; Outer < End; Outer++)
+	{
+		Jobs::ParallelFor(1000, 50, InnerFor, (void*)(size_t)Outer);
+	}
+}
+
+static void TestNestedParallelFor()
+{
+	ClearHits();
+	Jobs::ParallelFor(Count / 1000, 1, OuterFor, nullptr);
+	Check(EveryIndexOnce(1), "nested ParallelFor runs every index once");
+}
+
+// a chain of stages, each only starting once the one before has finished all of its jobs
+struct Stage
+{
+	volatile s32* Finished;
+	u32 Index;
+	Jobs::Counter* Before;
+	volatile s32* BadOrder;
+};
+
+static void RunStage(void* Data, u32 Begin, u32 End)
+{
+	Stage* s = (Stage*)Data;
+	if (s->Before && !s->Before->IsDone())
+	{
+		AtomicAdd(s->BadOrder, 1);
+	}
+	if (s->Index && s->Finished[s->Index - 1] != 16)
+	{
+		AtomicAdd(s->BadOrder, 1);
+	}
+	AtomicAdd(&s->Finished[s->Index], 1);
+}
+
+static void TestDependencies()
+{
+	static const u32 Stages = 8;
+	volatile s32 Finished[Stages] = {};
+	volatile s32 BadOrder = 0;
+	Stage StageData[Stages];
+	Jobs::Counter Done[Stages] = {};
+
+	// submitted last stage first, so nothing but the dependency keeps them in order
+	for (u32 s = Stages; s-- > 0;)
+	{
+		StageData[s] = { Finished, s, s ? &Done[s - 1] : nullptr, &BadOrder };
+		Done[s].Value = 16;
+	}
+	for (u32 s = Stages; s-- > 0;)
+	{
+		for (u32 j = 0; j < 16; j++)
+		{
+			Jobs::Submit(RunStage, &StageData[s], &Done[s], StageData[s].Before);
+		}
+		AtomicAdd(&Done[s].Value, -16);
+	}
+	Jobs::Wait(&Done[Stages - 1]);
+	for (u32 s = 0; s < Stages; s++)
+	{
+		Jobs::Wait(&Done[s]);
+	}
+	Check(BadOrder == 0, "a dependent job never starts before its dependency is done", (u32)BadOrder);
+	Check(Finished[Stages - 1] == 16, "every stage runs", (u32)Finished[Stages - 1]);
+}
+
+// a loader thread has no queue, its ParallelFor runs inline while the pool is busy with the main thread's
+static void LoaderMain(void* Data)
+{
+	volatile s32* Sum = (volatile s32*)Data;
+	for (u32 Round = 0; Round < 50; Round++)
+	{
+		Jobs::ParallelFor(Count / 2, 256, MarkRange, nullptr);
+	}
+	Check(!Jobs::IsWorkerThread() && Jobs::GetWorkerIndex() == 0, "a loader thread isn't a worker");
+	*Sum = 1;
+}
+
+static void TestOutsideThread()
+{
+	ClearHits();
+	volatile s32 LoaderDone = 0;
+	Thread Loader;
+	Loader.Start(LoaderMain, (void*)&LoaderDone);
+	for (u32 Round = 0; Round < 50; Round++)
+	{
+		Jobs::ParallelFor(Count, 256, MarkRange, nullptr);
+	}
+	Loader.Join();
+
+	bool Right = LoaderDone == 1;
+	for (u32 i = 0; i < Count; i++)
+	{
+		Right = Right && Hits[i] == (i < Count / 2 ? 100 : 50);
+	}
+	Check(Right, "ParallelFor from inside and outside the pool at once");
+}
+
+int main(int argc, char* argv[])
+{
+	// at least 3 workers besides this thread, so stealing happens even on a small machine
+	u32 Cores = GetProcessorCount();
+	Jobs::Init(Cores > 4 ? Cores - 1 : 3);
+	Check(Jobs::IsRunning() && Jobs::IsWorkerThread(), "Init starts the pool");
+
+	for (u32 Repeat = 0; Repeat < 20; Repeat++)
+	{
+		TestSubmitAndSteal();
+		TestNestedParallelFor();
+		TestDependencies();
+		Jobs::BeginFrame();
+	}
+	TestOutsideThread();
+	Jobs::Shutdown();
+
+	// without workers everything runs inline as it's submitted and still gets the same answers, except that a
+	// job whose dependency is submitted after it would wait forever, so that test needs the pool
+	TestSubmitAndSteal();
+	TestNestedParallelFor();
+
+	printf("%s\n", Failures ? "job tests failed" : "job tests passed");
+	return Failures ? 1 : 0;
+}
@@ -3,23 +3,241 @@
 
 void Arena::ReleaseMemory()
 {
-	Jogo::Free(BaseAddress);
+	Jogo::MemoryReport::Untrack(*this);
+	if (ReserveSize)
+	{
+		Jogo::Release(BaseAddress, ReserveSize);
+	}
+	else
+	{
+		Jogo::Free(BaseAddress);
+	}
 }
 
-Arena Arena::Create(size_t ArenaSize, size_t align)
+static size_t CheckAlignment(size_t align)
 {
-	Arena NewArena = { ArenaSize };
-
-	NewArena.BaseAddress = (u8*)Jogo::Allocate(ArenaSize);
-	NewArena.CurrentLocation = NewArena.BaseAddress;
 	if (align == 0 || (align & (align-1)))
 	{
 		align = 8;
 	}
 	if (align > 4096)
 		align = 4096;
+	return align;
+}
+
+Arena Arena::Create(size_t ArenaSize, size_t align, bool HugePages)
+{
+	Arena NewArena = { ArenaSize };
 
-	NewArena.Alignment = align;
+	NewArena.BaseAddress = (u8*)(HugePages ? Jogo::AllocateHuge(ArenaSize, &NewArena.Pages) : Jogo::Allocate(ArenaSize));
+	NewArena.CurrentLocation = NewArena.BaseAddress;
+	NewArena.Alignment = CheckAlignment(align);
+
+	return NewArena;
+}
+
+Arena Arena::CreateGrowable(size_t ReserveSize, size_t DecommitAbove, size_t CommitChunk, size_t align, bool HugePages)
+{
+	Arena NewArena = {};
+
+	// whole chunks keep every commit and decommit on a 64KB boundary, or a 2MB one for huge pages
+	size_t ChunkAlign = HugePages ? 2 * 1024 * 1024 : 65536;
+	CommitChunk = (Jogo::max(CommitChunk, ChunkAlign) + ChunkAlign - 1) & ~(ChunkAlign - 1);
+	ReserveSize = (Jogo::max(ReserveSize, CommitChunk) + CommitChunk - 1) / CommitChunk * CommitChunk;
+
+	u8* Base = (u8*)(HugePages ? Jogo::ReserveHuge(ReserveSize, &NewArena.Pages) : Jogo::Reserve(ReserveSize));
+	if (Base && Jogo::Commit(Base, CommitChunk))
+	{
+		NewArena.BaseAddress = Base;
+		NewArena.CurrentLocation = Base;
+		NewArena.ReserveSize = ReserveSize;
+		NewArena.Committed = CommitChunk;
+		NewArena.Size = CommitChunk;
+		NewArena.CommitChunk = CommitChunk;
+		NewArena.DecommitAbove = DecommitAbove;
+	}
+	else if (Base)
+	{
+		Jogo::Release(Base, ReserveSize);
+	}
+	NewArena.Alignment = CheckAlignment(align);
 
 	return NewArena;
 }
+
+bool Arena::Grow(size_t Request)
+{
+	if (!ReserveSize)
+		return false;
+
+	size_t Needed = (size_t)(CurrentLocation - BaseAddress) + Request;
+	if (Needed > ReserveSize)
+		return false;
+
+	size_t NewCommitted = Jogo::min((Needed + CommitChunk - 1) / CommitChunk * CommitChunk, ReserveSize);
+	if (!Jogo::Commit(BaseAddress + Committed, NewCommitted - Committed))
+		return false;
+
+	Committed = NewCommitted;
+	Size = Committed;
+	return true;
+}
+
+void Arena::Shrink()
+{
+	size_t Keep = Jogo::max((DecommitAbove + CommitChunk - 1) / CommitChunk * CommitChunk, CommitChunk);
+	size_t Used = (size_t)(CurrentLocation - BaseAddress);
+	if (Keep < Used || Keep >= Committed)
+		return;
+
+	Jogo::Decommit(BaseAddress + Keep, Committed - Keep);
+	Committed = Keep;
+	Size = Committed;
+}
+
+// the calling thread's index into every ConcurrentArena's SubChunks, handed out on first use
+volatile s32 NextSubChunkThread = 0;
+thread_local u32 SubChunkThread = ~0u;
+
+static u32 GetSubChunkThread()
+{
+	if (SubChunkThread == ~0u)
+	{
+		SubChunkThread = (u32)Jogo::AtomicAdd(&NextSubChunkThread, 1) - 1;
+	}
+	return SubChunkThread;
+}
+
+ConcurrentArena ConcurrentArena::Create(size_t ReserveSize, size_t SubChunkSize, size_t DecommitAbove, size_t align)
+{
+	ConcurrentArena NewArena = {};
+	NewArena.Alignment = CheckAlignment(align);
+	NewArena.SubChunkSize = (SubChunkSize + NewArena.Alignment - 1) & ~(NewArena.Alignment - 1);
+	NewArena.CommitChunk = Arena::DefaultCommitChunk;
+	NewArena.DecommitAbove = DecommitAbove;
+
+	ReserveSize = (Jogo::max(ReserveSize, NewArena.CommitChunk) + NewArena.CommitChunk - 1) / NewArena.CommitChunk * NewArena.CommitChunk;
+	u8* Base = (u8*)Jogo::Reserve(ReserveSize);
+	if (Base && Jogo::Commit(Base, NewArena.CommitChunk))
+	{
+		NewArena.BaseAddress = Base;
+		NewArena.ReserveSize = ReserveSize;
+		NewArena.Committed = NewArena.CommitChunk;
+	}
+	else if (Base)
+	{
+		Jogo::Release(Base, ReserveSize);
+	}
+	return NewArena;
+}
+
+void ConcurrentArena::ReleaseMemory()
+{
+	if (BaseAddress)
+	{
+		Jogo::Release(BaseAddress, ReserveSize);
+	}
+	BaseAddress = nullptr;
+}
+
+// claims Request bytes straight from the shared offset, committing more when it passes the top
+static u8* Claim(ConcurrentArena& Memory, size_t Request)
+{
+	s64 End = Jogo::AtomicAdd64(&Memory.Offset, (s64)Request);
+	if ((size_t)End > Memory.ReserveSize)
+		return nullptr;
+
+	if (End > Memory.Committed)
+	{
+		Memory.GrowLock.Lock();
+		if (End > Memory.Committed)
+		{
+			size_t NewCommitted = Jogo::min(((size_t)End + Memory.CommitChunk - 1) / Memory.CommitChunk * Memory.CommitChunk, Memory.ReserveSize);
+			if (!Jogo::Commit(Memory.BaseAddress + Memory.Committed, NewCommitted - Memory.Committed))
+			{
+				Memory.GrowLock.Unlock();
+				return nullptr;
+			}
+			Memory.Committed = NewCommitted;
+		}
+		Memory.GrowLock.Unlock();
+	}
+	return Memory.BaseAddress + End - Request;
+}
+
+void* ConcurrentArena::Allocate(size_t Request)
+{
+	if (!BaseAddress)
+		return nullptr;
+
+	size_t Aligned = (Request + Alignment - 1) & ~(Alignment - 1);
+	u32 Thread = GetSubChunkThread();
+	if (!SubChunkSize || Aligned > SubChunkSize / 4 || Thread >= MaxSubChunkThreads)
+		return Claim(*this, Aligned);
+
+	SubChunk& Chunk = SubChunks[Thread];
+	if ((size_t)(Chunk.End - Chunk.Current) < Aligned)
+	{
+		u8* NewChunk = Claim(*this, SubChunkSize);
+		if (!NewChunk)
+			return nullptr;
+		Chunk.Current = NewChunk;
+		Chunk.End = NewChunk + SubChunkSize;
+	}
+
+	u8* Result = Chunk.Current;
+	Chunk.Current += Aligned;
+	return Result;
+}
+
+void ConcurrentArena::Clear()
+{
+	Offset = 0;
+	memset(SubChunks, 0, sizeof(SubChunks));
+	if (DecommitAbove && (size_t)Committed > DecommitAbove)
+	{
+		size_t Keep = Jogo::max((DecommitAbove + CommitChunk - 1) / CommitChunk * CommitChunk, CommitChunk);
+		if (Keep < (size_t)Committed)
+		{
+			Jogo::Decommit(BaseAddress + Keep, Committed - Keep);
+			Committed = Keep;
+		}
+	}
+}
+
+size_t ConcurrentArena::GetUsed() const
+{
+	return Jogo::min((size_t)Offset, ReserveSize);
+}
+
+namespace Jogo
+{
+	// two is enough, a function only ever has to keep clear of the one arena its caller handed it
+	static const u32 NumScratchArenas = 2;
+	static const size_t ScratchReserveSize = 1024ull * 1024 * 1024;
+	thread_local Arena ScratchArenas[NumScratchArenas];
+
+	TempMemory GetScratch(const Arena* Conflict)
+	{
+		// compare the memory, not the Arena, callers often hold a copy
+		u32 Index = Conflict && Conflict->BaseAddress && Conflict->BaseAddress == ScratchArenas[0].BaseAddress ? 1 : 0;
+		Arena& Scratch = ScratchArenas[Index];
+		if (!Scratch.BaseAddress)
+		{
+			Scratch = Arena::CreateGrowable(ScratchReserveSize);
+		}
+		return TempMemory(Scratch);
+	}
+
+	void ReleaseScratch()
+	{
+		for (u32 i = 0; i < NumScratchArenas; i++)
+		{
+			if (ScratchArenas[i].BaseAddress)
+			{
+				ScratchArenas[i].ReleaseMemory();
+				ScratchArenas[i] = {};
+			}
+		}
+	}
+};
@@ -1,5 +1,13 @@
 #pragma once
 #include "int_types.h"
+#include "Platform.h"
+
+struct ArenaStats;
+
+// an Allocate the memory report can put down to the line it was called from
+#define JOGO_STRINGIZE2(x) #x
+#define JOGO_STRINGIZE(x) JOGO_STRINGIZE2(x)
+#define JOGO_ALLOCATE(Memory, Size) (Memory).Allocate(Size, __FILE__ ":" JOGO_STRINGIZE(__LINE__))
 
 struct Arena
 {
@@ -8,13 +16,29 @@ struct Arena
 	u8* CurrentLocation;
 	size_t Alignment;
 
-	void* Allocate(size_t Request)
+	// growable arenas only: Size is what's committed, and runs out at ReserveSize
+	size_t ReserveSize;
+	size_t Committed;
+	size_t CommitChunk;
+	size_t DecommitAbove;	// Clear gives back anything committed past this, 0 keeps it all
+
+	ArenaStats* Stats;		// null unless MemoryReport::Track was given this arena, copies made after that count too
+	u32 Pages;				// the Jogo::PageKind the OS gave it
+
+	static const size_t DefaultReserveSize = 64ull * 1024 * 1024 * 1024;
+	static const size_t DefaultCommitChunk = 256 * 1024;
+
+	void* Allocate(size_t Request, const char* Site = nullptr)
 	{
 		u8* TopLimit = BaseAddress + Size;
-		if (CurrentLocation + Request <= TopLimit)
+		if (CurrentLocation + Request <= TopLimit || Grow(Request))
 		{
 			u8* ReturnValue = CurrentLocation;
 			CurrentLocation += (Request + Alignment - 1) & ~(Alignment-1);		// round up to multiple of 8
+			if (Stats)
+			{
+				RecordAllocation(Request, Site);
+			}
 			return ReturnValue;
 		}
 		return nullptr;
@@ -23,9 +47,21 @@ struct Arena
 	void Clear()
 	{
 		CurrentLocation = BaseAddress;
+		if (DecommitAbove && Committed > DecommitAbove)
+		{
+			Shrink();
+		}
 	}
+	bool Grow(size_t Request);
+	void RecordAllocation(size_t Request, const char* Site);
+	void Shrink();
 	void ReleaseMemory();
-	static Arena Create(size_t ArenaSize, size_t align = 8);
+	// HugePages asks for 2MB pages, see Jogo::AllocateHuge
+	static Arena Create(size_t ArenaSize, size_t align = 8, bool HugePages = false);
+
+	// reserves ReserveSize of address space and commits it CommitChunk at a time as allocations reach it
+	// with HugePages the chunks are whole 2MB pages
+	static Arena CreateGrowable(size_t ReserveSize = DefaultReserveSize, size_t DecommitAbove = 0, size_t CommitChunk = DefaultCommitChunk, size_t align = 8, bool HugePages = false);
 	static Arena GetScratchArena(u8* memory, size_t size, size_t align = 1)
 	{
 		if (align == 0 || align > 8 || (align & (align-1)))
@@ -34,3 +70,68 @@ struct Arena
 		return stack;
 	}
 };
+
+// an arena any number of threads can Allocate from at once, every allocation is an atomic add on the offset
+// with SubChunkSize set each thread claims that much at a time and bumps inside it without atomics, allocations
+// bigger than a quarter of a sub-chunk still go straight to the offset
+// each thread gets a slot the first time it allocates from any ConcurrentArena and keeps it for life, past
+// MaxSubChunkThreads threads the rest allocate straight from the offset
+// memory is reserved up front and committed as the offset reaches it, like a growable Arena
+// Clear is the same as Arena's, everything goes at once, and no thread may be allocating while it runs
+struct ConcurrentArena
+{
+	static const u32 MaxSubChunkThreads = 64;
+
+	// a cache line each, only the owning thread touches it
+	struct SubChunk
+	{
+		u8* Current;
+		u8* End;
+		u8 Pad[48];
+	};
+
+	u8* BaseAddress;
+	size_t ReserveSize;
+	size_t Alignment;
+	size_t SubChunkSize;
+	size_t CommitChunk;
+	size_t DecommitAbove;
+	volatile s64 Committed;
+	u8 Pad[64];
+	volatile s64 Offset;
+	u8 Pad2[64];
+	Jogo::SpinLock GrowLock;
+	SubChunk SubChunks[MaxSubChunkThreads];
+
+	void* Allocate(size_t Request);
+	void Clear();
+	size_t GetUsed() const;
+	void ReleaseMemory();
+	static ConcurrentArena Create(size_t ReserveSize = Arena::DefaultReserveSize, size_t SubChunkSize = 64 * 1024, size_t DecommitAbove = 0, size_t align = 8);
+};
+
+// puts an arena back where it was when this was made, everything allocated from it since goes too
+struct TempMemory
+{
+	Arena* Owner;
+	u8* Location;
+
+	TempMemory(Arena& Memory) : Owner(&Memory), Location(Memory.CurrentLocation) {}
+	~TempMemory() { Owner->CurrentLocation = Location; }
+	TempMemory(const TempMemory&) = delete;
+	TempMemory& operator=(const TempMemory&) = delete;
+
+	void* Allocate(size_t Request) { return Owner->Allocate(Request); }
+	operator Arena&() { return *Owner; }
+};
+
+namespace Jogo
+{
+	// this thread's scratch arena, rewound when the TempMemory goes out of scope
+	// pass the arena your caller gave you as Conflict and you get the other one, so temporaries can't land on top of
+	// results still being built in the caller's arena
+	TempMemory GetScratch(const Arena* Conflict = nullptr);
+
+	// a thread that made scratch arenas gives them back before it exits
+	void ReleaseScratch();
+};
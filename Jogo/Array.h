@@ -0,0 +1,107 @@
+#pragma once
+#include "int_types.h"
+#include "Arena.h"
+#include <string.h>
+
+namespace Jogo
+{
+	// a growable array in an Arena, for plain data only: elements are moved with memcpy and never destructed
+	// growing extends the block in place when it is the last thing allocated from the arena, otherwise it moves
+	// to a block twice the size and the old one stays in the arena until the arena is cleared
+	// so pointers into it only last until the next Add
+	template<typename T>
+	struct Array
+	{
+		T* Data;
+		u32 Count;
+		u32 Capacity;
+		Arena* Memory;
+
+		static Array Create(Arena& Memory, u32 InitialCapacity = 16)
+		{
+			Array NewArray = {};
+			NewArray.Memory = &Memory;
+			NewArray.Reserve(InitialCapacity);
+			return NewArray;
+		}
+
+		T& operator[](u32 Index) { return Data[Index]; }
+		const T& operator[](u32 Index) const { return Data[Index]; }
+
+		T* begin() { return Data; }
+		T* end() { return Data + Count; }
+		const T* begin() const { return Data; }
+		const T* end() const { return Data + Count; }
+
+		bool Reserve(u32 NewCapacity)
+		{
+			if (NewCapacity <= Capacity)
+				return true;
+
+			size_t Rounding = Memory->Alignment - 1;
+			size_t OldBytes = ((size_t)Capacity * sizeof(T) + Rounding) & ~Rounding;
+			size_t NewBytes = (size_t)NewCapacity * sizeof(T);
+
+			// still on top of the arena, so just take the next bytes too
+			if (Data && (u8*)Data + OldBytes == Memory->CurrentLocation && Memory->Allocate(NewBytes - OldBytes))
+			{
+				Capacity = NewCapacity;
+				return true;
+			}
+
+			T* NewData = (T*)Memory->Allocate(NewBytes);
+			if (!NewData)
+				return false;
+
+			if (Count)
+			{
+				memcpy(NewData, Data, Count * sizeof(T));
+			}
+			Data = NewData;
+			Capacity = NewCapacity;
+			return true;
+		}
+
+		// a new element on the end, uninitialised, nullptr if the arena is full
+		T* Add()
+		{
+			if (Count == Capacity && !Reserve(Capacity ? Capacity * 2 : 16))
+				return nullptr;
+			return &Data[Count++];
+		}
+
+		bool Add(const T& Value)
+		{
+			T* Slot = Add();
+			if (!Slot)
+				return false;
+			*Slot = Value;
+			return true;
+		}
+
+		T& Last() { return Data[Count - 1]; }
+
+		T Pop()
+		{
+			return Data[--Count];
+		}
+
+		// O(1), moves the last element into the hole so the order changes
+		void RemoveSwap(u32 Index)
+		{
+			Data[Index] = Data[--Count];
+		}
+
+		// keeps the order, O(n)
+		void Remove(u32 Index)
+		{
+			memmove(Data + Index, Data + Index + 1, (Count - Index - 1) * sizeof(T));
+			Count--;
+		}
+
+		void Clear()
+		{
+			Count = 0;
+		}
+	};
+};
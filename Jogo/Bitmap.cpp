@@ -2,37 +2,318 @@
 #include "Arena.h"
 #include "Bitmap.h"
 #include "JMath.h"
+#include "Profiler.h"
+#include "Pixels.h"
+#include "Jobs.h"
 
 using namespace Jogo;
 
+BitmapTiles BitmapTiles::Create(u32 Width, u32 Height, Arena& arena)
+{
+	BitmapTiles NewTiles = {};
+	NewTiles.TilesX = (Width + TileSize - 1) >> TileShift;
+	NewTiles.TilesY = (Height + TileSize - 1) >> TileShift;
+	NewTiles.Flags = (u8*)arena.Allocate(NewTiles.TilesX * NewTiles.TilesY);
+	if (NewTiles.Flags)
+	{
+		memset(NewTiles.Flags, TILE_DAMAGED, NewTiles.TilesX * NewTiles.TilesY);
+	}
+	else
+	{
+		NewTiles.TilesX = NewTiles.TilesY = 0;
+	}
+	return NewTiles;
+}
+
+// the part of tile (tx, ty) inside the bitmap
+static Bitmap::Rect GetTileRect(const Bitmap& Target, u32 tx, u32 ty)
+{
+	s32 x = (s32)(tx << BitmapTiles::TileShift);
+	s32 y = (s32)(ty << BitmapTiles::TileShift);
+	return { x, y, min((s32)BitmapTiles::TileSize, (s32)Target.Width - x), min((s32)BitmapTiles::TileSize, (s32)Target.Height - y) };
+}
+
+// a clipped rect with its width and height made positive, for the mirrored blits
+static Bitmap::Rect GetSpan(const Bitmap::Rect& Clipped)
+{
+	Bitmap::Rect Span = Clipped;
+	if (Span.w < 0)
+	{
+		Span.x += Span.w + 1;
+		Span.w = -Span.w;
+	}
+	if (Span.h < 0)
+	{
+		Span.y += Span.h + 1;
+		Span.h = -Span.h;
+	}
+	return Span;
+}
+
+static void ClearTile(const Bitmap& Target, u32 tx, u32 ty)
+{
+	Bitmap::Rect Tile = GetTileRect(Target, tx, ty);
+	u32 Color = Target.Tiles->ClearColor;
+	if (Target.PixelSize == 1)
+	{
+		u8* row = Target.GetRow(Tile.y) + Tile.x;
+		for (s32 i = 0; i < Tile.h; i++)
+		{
+			__stosb(row, (unsigned char)Color, (size_t)Tile.w);
+			row += Target.Pitch;
+		}
+	}
+	else
+	{
+		u8* row = Target.GetRow(Tile.y) + Tile.x * 4;
+		for (s32 i = 0; i < Tile.h; i++)
+		{
+			Pixels::FillRow32((u32*)row, Color, (size_t)Tile.w);
+			row += Target.Pitch;
+		}
+	}
+}
+
+void Bitmap::Erase(u32 color)
+{
+	if (!Tiles || !Tiles->TilesX)
+	{
+		FillRect({ 0,0,(s32)Width,(s32)Height }, color);
+		return;
+	}
+
+	// tiles still solid from the last Erase to the same color are already right
+	BitmapTiles& t = *Tiles;
+	u32 Count = t.TilesX * t.TilesY;
+	bool SameColor = color == t.ClearColor;
+	t.ClearColor = color;
+	for (u32 i = 0; i < Count; i++)
+	{
+		if (!SameColor || !(t.Flags[i] & BitmapTiles::TILE_SOLID))
+		{
+			t.Flags[i] = BitmapTiles::TILE_CLEAR_PENDING | (t.Flags[i] & BitmapTiles::TILE_DAMAGED);
+		}
+	}
+	t.Flagged = Count;
+}
+
+Bitmap Bitmap::View(const Rect& r)
+{
+	Rect Clipped;
+	if (!ClipRect(r, Clipped))
+		return { 0, 0, PixelSize, Pitch };
+
+	// as if the whole rect were drawn now, which lands the clears and stops the tiles counting as solid
+	Touch(Clipped);
+	Bitmap NewView = { (u32)Clipped.w, (u32)Clipped.h, PixelSize, Pitch };
+	NewView.Pixels = GetRow(Clipped.y) + Clipped.x * PixelSize;
+	return NewView;
+}
+
+void Bitmap::TouchTiles(const Rect& Clipped, bool Opaque)
+{
+	if (Clipped.w <= 0 || Clipped.h <= 0)
+		return;
+
+	BitmapTiles& t = *Tiles;
+	u32 Left = (u32)Clipped.x >> BitmapTiles::TileShift;
+	u32 Top = (u32)Clipped.y >> BitmapTiles::TileShift;
+	u32 Right = (u32)(Clipped.x + Clipped.w - 1) >> BitmapTiles::TileShift;
+	u32 Bottom = (u32)(Clipped.y + Clipped.h - 1) >> BitmapTiles::TileShift;
+	for (u32 ty = Top; ty <= Bottom; ty++)
+	{
+		u8* Flags = t.Flags + ty * t.TilesX;
+		for (u32 tx = Left; tx <= Right; tx++)
+		{
+			u8 TileFlags = Flags[tx];
+			Flags[tx] = BitmapTiles::TILE_DAMAGED;
+			if (!(TileFlags & (BitmapTiles::TILE_CLEAR_PENDING | BitmapTiles::TILE_SOLID)))
+				continue;
+
+			if (TileFlags & BitmapTiles::TILE_CLEAR_PENDING)
+			{
+				// the clear is only skipped when every pixel of the tile is about to be overwritten
+				Rect Tile = GetTileRect(*this, tx, ty);
+				bool Covered = Opaque && Clipped.x <= Tile.x && Clipped.y <= Tile.y &&
+					Clipped.x + Clipped.w >= Tile.x + Tile.w && Clipped.y + Clipped.h >= Tile.y + Tile.h;
+				if (!Covered)
+				{
+					ClearTile(*this, tx, ty);
+				}
+			}
+			t.Flagged--;
+		}
+	}
+}
+
+void Bitmap::ResolveClears(const Rect& r) const
+{
+	if (!Tiles || !Tiles->Flagged || r.w <= 0 || r.h <= 0)
+		return;
+
+	BitmapTiles& t = *Tiles;
+	u32 Left = (u32)max(r.x, 0) >> BitmapTiles::TileShift;
+	u32 Top = (u32)max(r.y, 0) >> BitmapTiles::TileShift;
+	u32 Right = (u32)min(r.x + r.w - 1, (s32)Width - 1) >> BitmapTiles::TileShift;
+	u32 Bottom = (u32)min(r.y + r.h - 1, (s32)Height - 1) >> BitmapTiles::TileShift;
+	for (u32 ty = Top; ty <= Bottom; ty++)
+	{
+		u8* Flags = t.Flags + ty * t.TilesX;
+		for (u32 tx = Left; tx <= Right; tx++)
+		{
+			if (Flags[tx] & BitmapTiles::TILE_CLEAR_PENDING)
+			{
+				ClearTile(*this, tx, ty);
+				Flags[tx] = BitmapTiles::TILE_SOLID | BitmapTiles::TILE_DAMAGED;
+			}
+		}
+	}
+}
+
+u32 Bitmap::GetDamage(Rect* Rects, u32 MaxRects) const
+{
+	if (!MaxRects)
+		return 0;
+
+	if (!Tiles || !Tiles->TilesX)
+	{
+		Rects[0] = { 0, 0, (s32)Width, (s32)Height };
+		return 1;
+	}
+
+	const BitmapTiles& t = *Tiles;
+	u32 Count = 0;
+	for (u32 ty = 0; ty < t.TilesY; ty++)
+	{
+		const u8* Flags = t.Flags + ty * t.TilesX;
+		for (u32 tx = 0; tx < t.TilesX; tx++)
+		{
+			if (!(Flags[tx] & BitmapTiles::TILE_DAMAGED))
+				continue;
+
+			u32 End = tx + 1;
+			while (End < t.TilesX && (Flags[End] & BitmapTiles::TILE_DAMAGED))
+				End++;
+
+			Rect First = GetTileRect(*this, tx, ty);
+			Rect Last = GetTileRect(*this, End - 1, ty);
+			Rect Run = { First.x, First.y, Last.x + Last.w - First.x, First.h };
+			tx = End;
+
+			// a rect ending on the row above with the same run just gets taller
+			bool Merged = false;
+			for (u32 i = 0; i < Count; i++)
+			{
+				Rect& Above = Rects[i];
+				if (Above.x == Run.x && Above.w == Run.w && Above.y + Above.h == Run.y)
+				{
+					Above.h += Run.h;
+					Merged = true;
+					break;
+				}
+			}
+			if (Merged)
+				continue;
+
+			if (Count < MaxRects)
+			{
+				Rects[Count++] = Run;
+				continue;
+			}
+
+			// out of rects, the last one takes in everything else
+			Rect& Rest = Rects[MaxRects - 1];
+			s32 Right = max(Rest.x + Rest.w, Run.x + Run.w);
+			s32 Bottom = max(Rest.y + Rest.h, Run.y + Run.h);
+			Rest.x = min(Rest.x, Run.x);
+			Rest.y = min(Rest.y, Run.y);
+			Rest.w = Right - Rest.x;
+			Rest.h = Bottom - Rest.y;
+		}
+	}
+	return Count;
+}
+
+bool Bitmap::IsDamaged(const Rect& r) const
+{
+	if (!Tiles || !Tiles->TilesX)
+		return true;
+
+	Rect Clipped;
+	if (!ClipRect(r, Clipped))
+		return false;
+
+	Rect Span = GetSpan(Clipped);
+	const BitmapTiles& t = *Tiles;
+	for (u32 ty = (u32)Span.y >> BitmapTiles::TileShift; ty <= (u32)(Span.y + Span.h - 1) >> BitmapTiles::TileShift; ty++)
+	{
+		for (u32 tx = (u32)Span.x >> BitmapTiles::TileShift; tx <= (u32)(Span.x + Span.w - 1) >> BitmapTiles::TileShift; tx++)
+		{
+			if (t.Flags[ty * t.TilesX + tx] & BitmapTiles::TILE_DAMAGED)
+				return true;
+		}
+	}
+	return false;
+}
+
+void Bitmap::DamageAll()
+{
+	if (!Tiles)
+		return;
+
+	for (u32 i = 0; i < Tiles->TilesX * Tiles->TilesY; i++)
+	{
+		Tiles->Flags[i] |= BitmapTiles::TILE_DAMAGED;
+	}
+}
+
+void Bitmap::ClearDamage()
+{
+	if (!Tiles)
+		return;
+
+	for (u32 i = 0; i < Tiles->TilesX * Tiles->TilesY; i++)
+	{
+		Tiles->Flags[i] &= ~BitmapTiles::TILE_DAMAGED;
+	}
+}
+
 void Bitmap::FillRect(const Rect& r, u32 color)
 {
+	JOGO_ZONE("FillRect");
+
 	Rect clip;
 
 	if (!ClipRect(r, clip))
 		return;
 
+	Touch(clip, true);
 	if (PixelSize == 1)
 	{
-		u8* row = PixelA + (clip.y * Width + clip.x) * PixelSize;
+		u8* row = GetRow(clip.y) + clip.x;
 		for (s32 i = 0; i < clip.h; i++)
 		{
 			__stosb(row, (unsigned char)color, (size_t)clip.w);
-			row += Width;
+			row += Pitch;
 		}
 	}
 	else if (PixelSize == 4)
 	{
-		u32* row = PixelBGRA + (clip.y * Width + clip.x);
+		bool Stream = (size_t)clip.w * clip.h * 4 > Pixels::StreamThreshold;
+		u8* row = GetRow(clip.y) + clip.x * 4;
 		for (s32 i = 0; i < clip.h; i++)
 		{
-			__stosd((unsigned long*)row, (unsigned long)color, (size_t)clip.w);
-			row += Width;
+			Pixels::FillRow32((u32*)row, color, (size_t)clip.w, Stream);
+			row += Pitch;
+		}
+		if (Stream)
+		{
+			Pixels::EndStream();
 		}
 	}
 }
 
-bool Bitmap::ClipRect(const Rect& r, Rect& Clipped)
+bool Bitmap::ClipRect(const Rect& r, Rect& Clipped) const
 {
 	Clipped = r;
 
@@ -108,124 +389,171 @@ bool Bitmap::ClipRect(const Rect& r, Rect& Clipped)
 	return true;
 }
 
-void Bitmap::PasteBitmapSelectionScaled(const Rect& dest, Bitmap source, const Rect& srcRect, u32 color, u32 bkcolor)
+// a 16.16 source position wrapped into [0, Size)
+static s64 WrapFixed(s64 Position, u32 Size)
 {
-	if (!source.Pixels)
-		return;
+	s64 Limit = (s64)Size << 16;
+	Position %= Limit;
+	return Position < 0 ? Position + Limit : Position;
+}
 
-	Rect DstClip;
-	if (!ClipRect(dest, DstClip))
+// one row of a scaled 32bpp blit, forwards; x is where the first pixel samples in 16.16 and already wrapped
+static void ScaleRow32(u32* Dest, const u32* SrcRow, u32 SourceWidth, s32 Count, s64 x, u32 dx, u32 Factor, s32 FactorOffset)
+{
+	s64 Last = x + (s64)(Count - 1) * dx;
+	if (Last >> 16 >= SourceWidth)
+	{
+		// the span wraps around the source, which only the scalar loop handles
+		s64 Limit = (s64)SourceWidth << 16;
+		for (s32 i = 0; i < Count; i++)
+		{
+			Dest[i] = SrcRow[x >> 16];
+			x += dx;
+			if (x >= Limit)
+				x -= Limit;
+		}
 		return;
+	}
 
-	float sxdx = (float)srcRect.w / abs(dest.w);
-	float sydy = (float)srcRect.h / abs(dest.h);
-
-	float sourceX = srcRect.x + (DstClip.x - dest.x) * sxdx;
-	if (sourceX < 0 || sourceX > source.Width)
+	const u32* Source = SrcRow + (x >> 16);
+	if (!Factor)
 	{
-		sourceX = (float)(srcRect.x % source.Width);
-		if (sourceX < 0)
-			sourceX += source.Width;
+		Pixels::ScaleRow32(Dest, Source, (size_t)Count, (u32)(x & 0xffff), dx);
+		return;
 	}
 
-	float sourceY = srcRect.y + (DstClip.y - dest.y) * sydy;
-	if (sourceY < 0 || sourceY > source.Height)
+	// a clipped left edge can start partway through a source pixel's copies
+	s32 Head = min(FactorOffset ? (s32)Factor - FactorOffset : 0, Count);
+	for (s32 i = 0; i < Head; i++)
 	{
-		sourceY = (float)(srcRect.y % source.Height);
-		if (sourceY < 0)
-			sourceY += source.Width;
+		*Dest++ = *Source;
 	}
-
-	u8* DstRow = PixelA + DstClip.y * Width * PixelSize + DstClip.x * PixelSize;
-	s32 PixelStep = PixelSize;
-	s32 VertStep = Width;
-	if (DstClip.w < 0)
+	if (Head)
 	{
-		PixelStep = -PixelStep;
-		DstClip.w = -DstClip.w;
+		Source++;
 	}
-	if (DstClip.h < 0)
+	s32 Whole = (Count - Head) / (s32)Factor;
+	Pixels::ReplicateRow32(Dest, Source, (size_t)Whole, Factor);
+	Dest += Whole * Factor;
+	Source += Whole;
+	for (s32 i = Head + Whole * (s32)Factor; i < Count; i++)
 	{
-		DstClip.h = -DstClip.h;
-		VertStep = -VertStep;
+		*Dest++ = *Source;
 	}
-	for (s32 j = 0; j < DstClip.h; j++)
+}
+
+void Bitmap::PasteBitmapSelectionScaled(const Rect& dest, Bitmap source, const Rect& srcRect, u32 color, u32 bkcolor)
+{
+	JOGO_ZONE("PasteBitmapSelectionScaled");
+
+	if (!source.Pixels || !dest.w || !dest.h || srcRect.w <= 0 || srcRect.h <= 0)
+		return;
+
+	Rect DstClip;
+	if (!ClipRect(dest, DstClip))
+		return;
+
+	bool Opaque = PixelSize == source.PixelSize || (bkcolor & 0xff000000);
+	source.ResolveClears();
+	Touch(GetSpan(DstClip), Opaque);
+
+	// 16.16 steps, rounded up so that with an exact integer scale every source pixel's first copy lands on it
+	u32 DestW = (u32)abs(dest.w);
+	u32 DestH = (u32)abs(dest.h);
+	u32 dx = (u32)((((u64)srcRect.w << 16) + DestW - 1) / DestW);
+	u32 dy = (u32)((((u64)srcRect.h << 16) + DestH - 1) / DestH);
+
+	// the source wraps, so clipped or out of range rects sample it like a tiled texture
+	s32 SkipX = abs(DstClip.x - dest.x);
+	s32 SkipY = abs(DstClip.y - dest.y);
+	s64 StartX = WrapFixed(((s64)srcRect.x << 16) + (s64)SkipX * dx, source.Width);
+	s64 y = WrapFixed(((s64)srcRect.y << 16) + (s64)SkipY * dy, source.Height);
+	s64 LimitX = (s64)source.Width << 16;
+	s64 LimitY = (s64)source.Height << 16;
+
+	// 2x to 4x replicate whole source pixels rather than sampling
+	u32 Factor = 0;
+	if (DestW % srcRect.w == 0 && DestW / srcRect.w >= 2 && DestW / srcRect.w <= Pixels::MaxReplicate)
 	{
-		u8* Dest = DstRow;
-		float x = sourceX;
+		Factor = DestW / srcRect.w;
+	}
 
-		if (PixelSize == source.PixelSize)
+	s32 PixelStep = DstClip.w < 0 ? -1 : 1;
+	s32 Count = abs(DstClip.w);
+	s32 Rows = abs(DstClip.h);
+	if (!Count || !Rows)
+		return;
+
+	s64 VertStep = DstClip.h < 0 ? -(s64)Pitch : (s64)Pitch;
+	u8* DstRow = GetRow(DstClip.y) + (s64)DstClip.x * PixelSize;
+	u8* LastRow = nullptr;
+	s64 LastSourceY = -1;
+
+	// mask rows are sampled into this first so the vector expansion can take them
+	TempMemory Scratch = GetScratch();
+	u8* Samples = (PixelSize == 4 && source.PixelSize == 1) ? (u8*)Scratch.Allocate(Count) : nullptr;
+
+	for (s32 j = 0; j < Rows; j++)
+	{
+		// the written span of the row, lowest address first
+		u8* RowStart = PixelStep < 0 ? DstRow - (s64)(Count - 1) * PixelSize : DstRow;
+		s64 SourceY = y >> 16;
+		if (Opaque && LastRow && SourceY == LastSourceY)
+		{
+			// scaled up vertically this row is the last one over again
+			memcpy(RowStart, LastRow, (size_t)Count * PixelSize);
+		}
+		else if (PixelSize == source.PixelSize)
 		{
-			if (PixelSize == 1)
+			if (PixelSize == 4 && PixelStep > 0)
 			{
-				u8* SrcRow = source.PixelA + (u32)sourceY * source.Width;
-				for (s32 i = 0; i < DstClip.w; i++)
-				{
-					x += sxdx;
-					if (x < 0)
-						x += source.Width;
-					if (x >= source.Width)
-						x -= source.Width;
-					*Dest = *(SrcRow + (u32)x);
-					Dest += PixelStep;
-				}
+				ScaleRow32((u32*)RowStart, source.GetRowBGRA((s32)SourceY), source.Width, Count, StartX, dx, Factor, SkipX % max((s32)Factor, 1));
 			}
 			else
 			{
-				u32* SrcRow = source.PixelBGRA + (u32)sourceY * source.Width;
-				for (s32 i = 0; i < DstClip.w; i++)
+				u8* SrcRow = source.GetRow((s32)SourceY);
+				u8* Dest = DstRow;
+				s64 x = StartX;
+				for (s32 i = 0; i < Count; i++)
 				{
-					x += sxdx;
-					if (x < 0)
-						x += source.Width;
-					if (x >= source.Width)
-						x -= source.Width;
-					*((u32*)Dest) = *((u32*)SrcRow + (u32)x);
-					Dest += PixelStep;
+					if (PixelSize == 1)
+						*Dest = SrcRow[x >> 16];
+					else
+						*(u32*)Dest = ((u32*)SrcRow)[x >> 16];
+					Dest += PixelStep * (s32)PixelSize;
+					x += dx;
+					if (x >= LimitX)
+						x -= LimitX;
 				}
 			}
 		}
-		else if (PixelSize == 4)
+		else if (PixelSize == 4 && Samples)
 		{
-			if (bkcolor & 0xff000000)
+			u8* SrcRow = source.GetRow((s32)SourceY);
+			s64 x = StartX;
+			for (s32 i = 0; i < Count; i++)
 			{
-				u8* SrcRow = source.PixelA + (u32)sourceY * source.Width;
-				for (s32 i = 0; i < DstClip.w; i++)
-				{
-					if (x < 0) x += source.Width;
-					if (x >= source.Width) x -= source.Width;
-					*((u32*)Dest) = (*(SrcRow + (u32)x)) ? color : bkcolor;
-					Dest += PixelStep;
-					x += sxdx;
-				}
-			}
-			else
-			{
-				u8* SrcRow = source.PixelA + (u32)sourceY * source.Width;
-				for (s32 i = 0; i < DstClip.w; i++)
-				{
-					if (x < 0) x += source.Width;
-					if (x >= source.Width) x -= source.Width;
-					if (*(SrcRow + (u32)x))
-					{
-						*((u32*)Dest) = color;
-					}
-					Dest += PixelStep;
-					x += sxdx;
-				}
+				Samples[PixelStep > 0 ? i : Count - 1 - i] = SrcRow[x >> 16];
+				x += dx;
+				if (x >= LimitX)
+					x -= LimitX;
 			}
+			Pixels::ExpandMask32((u32*)RowStart, Samples, (size_t)Count, color, bkcolor, (bkcolor & 0xff000000) != 0);
 		}
-		sourceY += sydy;
-		if (sourceY < 0)
-			sourceY += source.Height;
-		if (sourceY >= source.Height)
-			sourceY -= source.Height;
-		DstRow += (s64)VertStep * PixelSize;
+		LastRow = RowStart;
+		LastSourceY = SourceY;
+
+		y += dy;
+		if (y >= LimitY)
+			y -= LimitY;
+		DstRow += VertStep;
 	}
 }
 
 void Bitmap::PasteBitmapSelection(int x, int y, Bitmap source, const Rect& srcRect, u32 color, u32 bkcolor)
 {
+	JOGO_ZONE("PasteBitmapSelection");
+
 	if (!source.Pixels)
 		return;
 
@@ -239,48 +567,87 @@ void Bitmap::PasteBitmapSelection(int x, int y, Bitmap source, const Rect& srcRe
 
 	SrcClip.x += DstClip.x - x;
 	SrcClip.y += DstClip.y - y;
-	u8* SrcRow = source.PixelA + SrcClip.y * source.Width * source.PixelSize + SrcClip.x * source.PixelSize;
-	u8* DstRow = PixelA + DstClip.y * Width * PixelSize + DstClip.x * PixelSize;
+	source.ResolveClears({ SrcClip.x, SrcClip.y, DstClip.w, DstClip.h });
+	Touch(DstClip, PixelSize == source.PixelSize || (bkcolor & 0xff000000));
+	u8* SrcRow = source.GetRow(SrcClip.y) + SrcClip.x * source.PixelSize;
+	u8* DstRow = GetRow(DstClip.y) + DstClip.x * PixelSize;
 
 	if (PixelSize == source.PixelSize)
 	{
 		for (s32 j = 0; j < DstClip.h; j++)
 		{
 			__movsb(DstRow, SrcRow, DstClip.w * PixelSize);
-			SrcRow += source.Width * PixelSize;
-			DstRow += Width * PixelSize;
+			SrcRow += source.Pitch;
+			DstRow += Pitch;
 		}
 	}
 	else if (PixelSize == 4)
 	{
+		bool Opaque = (bkcolor & 0xff000000) != 0;
 		for (s32 j = 0; j < DstClip.h; j++)
 		{
-			u8* src = SrcRow;
-			u32* dst = (u32*)DstRow;
-			if (bkcolor & 0xff000000)
-			{
-				for (s32 i = 0; i < DstClip.w; i++)
-				{
-					*dst = *src ? color : bkcolor;
-					src++;
-					dst++;
-				}
-			}
-			else
+			Pixels::ExpandMask32((u32*)DstRow, SrcRow, (size_t)DstClip.w, color, bkcolor, Opaque);
+			SrcRow += source.Pitch;
+			DstRow += Pitch;
+		}
+	}
+}
+
+void Bitmap::PasteBitmapBlend(int x, int y, Bitmap source, const Rect& srcRect, BlendMode Mode, u32 color)
+{
+	JOGO_ZONE("PasteBitmapBlend");
+
+	// blending into an 8bpp bitmap has no meaning for the masks that live there
+	if (!source.Pixels || PixelSize != 4)
+		return;
+
+	Rect SrcClip;
+	if (!source.ClipRect(srcRect, SrcClip))
+		return;
+
+	Rect DstClip;
+	if (!ClipRect({ x, y, SrcClip.w, SrcClip.h }, DstClip))
+		return;
+
+	SrcClip.x += DstClip.x - x;
+	SrcClip.y += DstClip.y - y;
+	source.ResolveClears({ SrcClip.x, SrcClip.y, DstClip.w, DstClip.h });
+
+	// never opaque, the destination shows through wherever the source is translucent so its clears have to land
+	Touch(DstClip);
+	u8* SrcRow = source.GetRow(SrcClip.y) + SrcClip.x * source.PixelSize;
+	u8* DstRow = GetRow(DstClip.y) + DstClip.x * PixelSize;
+
+	for (s32 j = 0; j < DstClip.h; j++)
+	{
+		u32* Row = (u32*)DstRow;
+		size_t Count = (size_t)DstClip.w;
+		if (source.PixelSize == 4)
+		{
+			const u32* Source = (const u32*)SrcRow;
+			switch (Mode)
 			{
-				for (s32 i = 0; i < DstClip.w; i++)
-				{
-					if (*src)
-					{
-						*dst = color;
-					}
-					src++;
-					dst++;
-				}
+			case BLEND_OVER:
+				Pixels::BlendOver32(Row, Source, Count);
+				break;
+			case BLEND_ADD:
+				Pixels::BlendAdd32(Row, Source, Count);
+				break;
+			case BLEND_COLORKEY:
+				Pixels::ColorKey32(Row, Source, Count, color);
+				break;
 			}
-			SrcRow += source.Width;
-			DstRow += Width * PixelSize;
 		}
+		else if (Mode == BLEND_COLORKEY)
+		{
+			Pixels::ExpandMask32(Row, SrcRow, Count, color, 0, false);
+		}
+		else
+		{
+			Pixels::BlendCoverage32(Row, SrcRow, Count, color, Mode == BLEND_ADD);
+		}
+		SrcRow += source.Pitch;
+		DstRow += Pitch;
 	}
 }
 
@@ -780,7 +1147,8 @@ void Bitmap::TriangleScanLine(s32 y, Edge& Left, Edge& Right, Gradient& Grad)
 	s32 fixg = (s32)(g * 65535.0f);
 	s32 fixb = (s32)(b * 65535.0f);
 
-	u32* pixel = PixelBGRA + y * Width + x1;
+	Touch({ x1, y, x2 - x1, 1 });
+	u32* pixel = GetRowBGRA(y) + x1;
 
 	for (s32 x = x1; x < x2; x++)
 	{
@@ -796,6 +1164,8 @@ void Bitmap::TriangleScanLine(s32 y, Edge& Left, Edge& Right, Gradient& Grad)
 
 void Bitmap::FillTriangle(VertexLit corners[])
 {
+	JOGO_ZONE("FillTriangle");
+
 	Gradient grad = MakeGradient(corners);
 
 	u32 TopIndex = 0;
@@ -903,6 +1273,8 @@ static void point_to_fixed_xform(s32* ox, s32* oy, const Bitmap::VertexTexLit& i
 
 void Bitmap::FillTriangle(const VertexTexLit& a, const VertexTexLit& b, const VertexTexLit& c, const Bitmap& texture)
 {
+	JOGO_ZONE("FillTriangle");
+
 	s32 x0, x1, x2;
 	s32 y0, y1, y2;
 	s32 minx, miny, maxx, maxy;
@@ -956,6 +1328,7 @@ void Bitmap::FillTriangle(const VertexTexLit& a, const VertexTexLit& b, const Ve
 	maxy = min(fixed_ceil(max3(y0, y1, y2)), (s32)Height);
 	if (minx >= maxx || miny >= maxy)
 		return;
+	Touch({ minx, miny, maxx - minx, maxy - miny });
 
 	// edge vectors
 	dx10 = x1 - x0; dy10 = y1 - y0;
@@ -969,7 +1342,7 @@ void Bitmap::FillTriangle(const VertexTexLit& a, const VertexTexLit& b, const Ve
 
 	// rasterize
 	for (y = miny; y < maxy; y++) {
-		u32* line = PixelBGRA + y * Width;
+		u32* line = GetRowBGRA(y);
 		EdgeDist ei0 = e0, ei1 = e1, ei2 = e2;
 
 		for (x = minx; x < maxx; x++) {
@@ -1001,6 +1374,8 @@ void Bitmap::FillTriangle(const VertexTexLit& a, const VertexTexLit& b, const Ve
 
 void Bitmap::FillTriangleTL(const VertexTexLit& a, const VertexTexLit& b, const VertexTexLit& c, const Bitmap& texture)
 {
+	JOGO_ZONE("FillTriangleTL");
+
 	float x0, x1, x2;
 	float y0, y1, y2;
 	s32 minx, miny, maxx, maxy;
@@ -1049,6 +1424,7 @@ void Bitmap::FillTriangleTL(const VertexTexLit& a, const VertexTexLit& b, const
 	maxy = min((s32)ceil(max3(y0, y1, y2)), (s32)Height);
 	if (minx >= maxx || miny >= maxy)
 		return;
+	Touch({ minx, miny, maxx - minx, maxy - miny });
 
 	// edge vectors
 	dx10 = (x1 - x0); dy10 = (y1 - y0);
@@ -1068,7 +1444,7 @@ void Bitmap::FillTriangleTL(const VertexTexLit& a, const VertexTexLit& b, const
 
 	// rasterize
 	for (y = miny; y < maxy; y++) {
-		u32* line = PixelBGRA + y * Width;	// tgt->data + y * tgt->w;
+		u32* line = GetRowBGRA(y);	// tgt->data + y * tgt->w;
 		float ei0 = e0, ei1 = e1, ei2 = e2;
 
 		for (x = minx; x < maxx; x++) {
@@ -1110,6 +1486,8 @@ void Bitmap::FillTriangleTL(const VertexTexLit& a, const VertexTexLit& b, const
 
 void Bitmap::FillTriangleTexLit(const VertexTexLit& a, const VertexTexLit& b, const VertexTexLit& c, const Bitmap& texture)
 {
+	JOGO_ZONE("FillTriangleTexLit");
+
 	float x0, x1, x2;
 	float y0, y1, y2;
 	s32 minx, miny, maxx, maxy;
@@ -1163,6 +1541,7 @@ void Bitmap::FillTriangleTexLit(const VertexTexLit& a, const VertexTexLit& b, co
 	maxy = min((s32)ceil(max3(y0, y1, y2)), (s32)Height);
 	if (minx >= maxx || miny >= maxy)
 		return;
+	Touch({ minx, miny, maxx - minx, maxy - miny });
 
 	// edge vectors
 	dx10 = w01 * (x1 - x0); dy10 = w01 * (y1 - y0);
@@ -1176,7 +1555,7 @@ void Bitmap::FillTriangleTexLit(const VertexTexLit& a, const VertexTexLit& b, co
 
 	// rasterize
 	for (y = miny; y < maxy; y++) {
-		u32* line = PixelBGRA + y * Width;	// tgt->data + y * tgt->w;
+		u32* line = GetRowBGRA(y);	// tgt->data + y * tgt->w;
 		float ei0 = e0, ei1 = e1, ei2 = e2;
 
 		for (x = minx; x < maxx; x++) {
@@ -1207,6 +1586,8 @@ void Bitmap::FillTriangleTexLit(const VertexTexLit& a, const VertexTexLit& b, co
 
 void Bitmap::FillTriangleTexLitInt(const VertexTexLit& a, const VertexTexLit& b, const VertexTexLit& c, const Bitmap& texture)
 {
+	JOGO_ZONE("FillTriangleTexLitInt");
+
 	s32 x0, x1, x2;
 	s32 y0, y1, y2;
 	s32 minx, miny, maxx, maxy;
@@ -1265,6 +1646,7 @@ void Bitmap::FillTriangleTexLitInt(const VertexTexLit& a, const VertexTexLit& b,
 	maxy = min(fixed_ceil(max3(y0, y1, y2)), (s32)Height);
 	if (minx >= maxx || miny >= maxy)
 		return;
+	Touch({ minx, miny, maxx - minx, maxy - miny });
 
 	// edge vectors5
 	dx10 = (w01fix * (x1 - x0)) >> SUBPIXEL_SHIFT; dy10 = (w01fix * (y1 - y0)) >> SUBPIXEL_SHIFT;
@@ -1278,7 +1660,7 @@ void Bitmap::FillTriangleTexLitInt(const VertexTexLit& a, const VertexTexLit& b,
 
 	// rasterize
 	for (y = miny; y < maxy; y++) {
-		u32* line = PixelBGRA + y * Width;
+		u32* line = GetRowBGRA(y);
 		EdgeDist ei0 = e0, ei1 = e1, ei2 = e2;
 
 		for (x = minx; x < maxx; x++) {
@@ -1318,8 +1700,42 @@ void Bitmap::FillTriangleTexLitInt(const VertexTexLit& a, const VertexTexLit& b,
 // more than one texture
 // texture filtering - bilinear + mip-mapping
 
+// the rows of a mapped BMP going into a Bitmap, a batch of them per job
+struct BMPRows
+{
+	const u8* FilePixels;	// the first row in the file, which is the bottom one unless TopDown
+	u32 FileStride;
+	u32 FilePixelSize;
+	bool TopDown;
+	Bitmap Image;
+};
+
+static void ConvertBMPRows(void* Data, u32 Begin, u32 End)
+{
+	const BMPRows& Rows = *(const BMPRows*)Data;
+	const Bitmap& Image = Rows.Image;
+	for (u32 y = Begin; y < End; y++)
+	{
+		const u8* Source = Rows.FilePixels + (size_t)(Rows.TopDown ? y : Image.Height - 1 - y) * Rows.FileStride;
+		if (Rows.FilePixelSize == 3)
+		{
+			Pixels::Expand24To32(Image.GetRowBGRA((s32)y), Source, Image.Width);
+		}
+		else
+		{
+			memcpy(Image.GetRow((s32)y), Source, (size_t)Image.Width * Image.PixelSize);
+		}
+	}
+}
+
+// images smaller than this convert on the calling thread, it's over before the jobs would start
+static const size_t ParallelLoadBytes = 1024 * 1024;
+static const u32 LoadBatchRows = 64;
+
 Bitmap Bitmap::Load(const char* filename, Arena& arena)
 {
+	JOGO_ZONE("Load");
+
 #pragma pack(push,2)
 	struct BitmapHeader
 	{
@@ -1344,73 +1760,54 @@ Bitmap Bitmap::Load(const char* filename, Arena& arena)
 	} Header = {};
 #pragma pack(pop)
 
-	FILE* fp = nullptr;
-	if (!fopen_s(&fp, filename, "rb"))
+	Bitmap EmptyBitmap = {};
+	MappedFile File;
+	if (!MapFile(filename, File))
+		return EmptyBitmap;
+
+	if (File.Size >= sizeof(BitmapHeader))
+	{
+		memcpy(&Header, File.Data, sizeof(BitmapHeader));
+	}
+
+	u32 FilePixelSize = Header.BitCount / 8;
+	u32 ImageHeight = Header.Height < 0 ? (u32)-Header.Height : (u32)Header.Height;
+	bool Supported = (Header.BitCount == 8 || Header.BitCount == 24 || Header.BitCount == 32) &&
+		Header.Width > 0 && Header.Width <= 65536 && ImageHeight && ImageHeight <= 65536;
+
+	// rows are padded to 4 bytes in the file
+	u32 FileStride = ((u32)Header.Width * FilePixelSize + 3) & ~3u;
+	if (!Supported || Header.ImageOffset > File.Size || (size_t)FileStride * ImageHeight > File.Size - Header.ImageOffset)
+	{
+		UnmapFile(File);
+		return EmptyBitmap;
+	}
+
+	BMPRows Rows = { File.Data + Header.ImageOffset, FileStride, FilePixelSize, Header.Height < 0 };
+
+	// already what a Bitmap holds, so it's used where it lies and the mapping stays for good, like the arena
+	// memory a converted image would be in; u32 loads want the pixels 4 aligned, which a V4 or V5 header breaks
+	if (FilePixelSize == 4 && Rows.TopDown && !((size_t)Rows.FilePixels & 3))
+	{
+		Bitmap Image = { (u32)Header.Width, ImageHeight, 4, FileStride };
+		Image.Pixels = (void*)Rows.FilePixels;
+		return Image;
+	}
+
+	// convert 24-bit bitmaps to 32-bit
+	Rows.Image = Create((u32)Header.Width, ImageHeight, FilePixelSize == 3 ? 4 : FilePixelSize, arena, true);
+	if (Rows.Image.Pixels)
 	{
-		fread(&Header, sizeof(BitmapHeader), 1, fp);
-		if (Header.ImageOffset != sizeof(BitmapHeader))
+		// the App starts the workers before a derived constructor loads anything, off a pool thread this runs inline
+		if ((size_t)Rows.Image.Pitch * ImageHeight > ParallelLoadBytes)
 		{
-			fseek(fp, Header.ImageOffset, SEEK_SET);
+			Jobs::ParallelFor(ImageHeight, LoadBatchRows, ConvertBMPRows, &Rows);
 		}
-
-		if (Header.BitCount == 8 || Header.BitCount == 24 || Header.BitCount == 32)
+		else
 		{
-			u32 FlipImage = Header.Height > 0;
-			u32 ImageHeight = Header.Height < 0 ? -Header.Height : Header.Height;
-
-			if (Header.Width <= 65536 && ImageHeight <= 65536)
-			{
-				u32 FilePixelSize = Header.BitCount / 8;
-				// convert 24-bit bitmaps to 32-bit
-				u32 ImagePixelSize = FilePixelSize;
-				if (ImagePixelSize == 3)
-					ImagePixelSize = 4;
-
-				Bitmap Image = { (u32)Header.Width, ImageHeight, ImagePixelSize };
-				Image.Pixels = arena.Allocate(Header.Width * ImageHeight * ImagePixelSize);
-				if (Image.Pixels != nullptr)
-				{
-					u8* RowPtr = Image.PixelA;
-					s32 ImageStride = Image.Width * ImagePixelSize;
-					if (FlipImage)
-					{
-						RowPtr = Image.PixelA + (ImageHeight - 1) * Header.Width * ImagePixelSize;
-						ImageStride = -ImageStride;
-					}
-					u32 LeftOver = Image.Width * FilePixelSize & 0x3;
-					LeftOver = LeftOver ? 4 - LeftOver : 0;
-					for (u32 i = 0; i < ImageHeight; i++)
-					{
-						fread(RowPtr, Image.Width * FilePixelSize, 1, fp);
-						if (LeftOver)
-						{
-							fseek(fp, LeftOver, SEEK_CUR);
-						}
-
-						// convert 24-bit bitmaps to 32-bit
-						if (FilePixelSize == 3)
-						{
-							u8* EndOfFileRow = RowPtr + Image.Width * FilePixelSize - 1;
-							u8* EndOfImageRow = RowPtr + Image.Width * ImagePixelSize - 1;
-							for (u32 j = 0; j < Image.Width; j++)
-							{
-								*EndOfImageRow-- = 0xff;
-								*EndOfImageRow-- = *EndOfFileRow--;
-								*EndOfImageRow-- = *EndOfFileRow--;
-								*EndOfImageRow-- = *EndOfFileRow--;
-							}
-						}
-						RowPtr += ImageStride;
-					}
-
-					fclose(fp);
-					return Image;
-				}
-			}
+			ConvertBMPRows(&Rows, 0, ImageHeight);
 		}
-		fclose(fp);
 	}
-
-	Bitmap EmptyBitmap = {};
-	return EmptyBitmap;
+	UnmapFile(File);
+	return Rows.Image;
 }
@@ -1,56 +1,144 @@
 #pragma once
 
-#include <intrin.h>
+#include "Platform.h"
 #include "int_types.h"
 #include "Arena.h"
 #include "JMath.h"
 
+// what a Bitmap knows about each TileSize square of itself, for a bitmap that's drawn over every frame
+// Erase only flags the tiles, each gets its clear the first time something touches it or at Show, and a tile
+// that something opaque covers completely never gets it at all
+// a tile still solid in the clear color from the last Erase doesn't need clearing again either
+// tiles whose pixels may have changed since the last Show are damaged, and Show only presents those
+struct BitmapTiles
+{
+	static const u32 TileShift = 5;
+	static const u32 TileSize = 1 << TileShift;
+
+	enum : u8
+	{
+		TILE_CLEAR_PENDING = 1,		// the pixels are stale, the tile is ClearColor
+		TILE_SOLID = 2,				// the pixels are all ClearColor and nothing has been drawn since
+		TILE_DAMAGED = 4,			// changed since the last Show
+	};
+
+	u32 TilesX;
+	u32 TilesY;
+	u32 ClearColor;
+	u32 Flagged;		// tiles pending a clear or solid, while it's 0 there are no clears to resolve
+	u8* Flags;
+
+	// every tile starts damaged, nothing has been presented yet
+	static BitmapTiles Create(u32 Width, u32 Height, Arena& arena);
+};
+
 struct Bitmap
 {
 	u32 Width;
 	u32 Height;
 	u32 PixelSize;		// in bytes
+	u32 Pitch;			// bytes from one row to the next, Width * PixelSize when packed, more when padded or a View
 	union
 	{
 		void* Pixels;
 		u8* PixelA;
 		u32* PixelBGRA;
 	};
+	BitmapTiles* Tiles;	// optional, and shared by every copy of the Bitmap
 
 	struct Rect
 	{
 		s32 x, y, w, h;
 	};
 
-	void Erase(u32 color)
+	// Create's rows start this aligned when asked, so row kernels can use aligned loads and stores and no
+	// two rows share a cache line
+	static const u32 RowAlignment = 64;
+
+	u8* GetRow(s32 y) const
 	{
-		FillRect({ 0,0,(s32)Width,(s32)Height }, color);
+		return PixelA + (ptrdiff_t)y * Pitch;
 	}
 
+	u32* GetRowBGRA(s32 y) const
+	{
+		return (u32*)GetRow(y);
+	}
+
+	// r clipped to the bitmap, as a bitmap aliasing its pixels, nothing is copied
+	// a view has no Tiles, so it can be handed to a worker without sharing the flags: the parent's pending clears
+	// under it are done and its tiles marked damaged when it's taken, and nothing after that is tracked
+	// so take views after the parent's Erase, and don't keep them across frames
+	Bitmap View(const Rect& r);
+
+	void Erase(u32 color);
+
+	// every primitive calls this with the clipped rect it's about to write before it writes it, Opaque if every
+	// pixel of the rect is overwritten; code that writes Pixels itself has to do the same
+	void Touch(const Rect& Clipped, bool Opaque = false)
+	{
+		if (Tiles)
+		{
+			TouchTiles(Clipped, Opaque);
+		}
+	}
+	void TouchTiles(const Rect& Clipped, bool Opaque);
+
+	// the pending clears under r done now, for reading the pixels; Show does the whole bitmap
+	void ResolveClears(const Rect& r) const;
+	void ResolveClears() const
+	{
+		ResolveClears({ 0, 0, (s32)Width, (s32)Height });
+	}
+
+	// the damaged tiles as up to MaxRects rects, runs of tiles merged across and then down
+	// past MaxRects the last rect grows to cover the rest; 0 means nothing changed since the last Show
+	// a bitmap without Tiles is always damaged all over
+	u32 GetDamage(Rect* Rects, u32 MaxRects) const;
+	bool IsDamaged(const Rect& r) const;
+
+	// for when the whole bitmap has to be presented again, like a window being uncovered
+	void DamageAll();
+	void ClearDamage();
+
 	void FillRect(const Rect& r, u32 color);
-	bool ClipRect(const Rect& r, Rect& Clipped);
+	bool ClipRect(const Rect& r, Rect& Clipped) const;
 	void PasteBitmap(int x, int y, Bitmap source, u32 color, u32 bkcolor = 0)
 	{
 		PasteBitmapSelection(x, y, source, { 0, 0, (s32)source.Width, (s32)source.Height }, color, bkcolor);
 	}
 	void PasteBitmapSelectionScaled(const Rect& dest, Bitmap source, const Rect& srcRect, u32 color, u32 bkcolor = 0);
 	void PasteBitmapSelection(int x, int y, Bitmap source, const Rect& srcRect, u32 color, u32 bkcolor = 0);
+
+	// 32bpp sources are premultiplied BGRA blended over, added, or copied except for pixels equal to color
+	// 8bpp sources are coverage masks tinting color's rgb, over and add blend it, color key writes it wherever
+	// the coverage isn't 0
+	enum BlendMode : u32
+	{
+		BLEND_OVER,
+		BLEND_ADD,
+		BLEND_COLORKEY,
+	};
+	void PasteBitmapBlend(int x, int y, Bitmap source, const Rect& srcRect, BlendMode Mode, u32 color = 0);
 	void SetPixel(s32 x, s32 y, u32 color)
 	{
 		if (x < 0 || x >= (s32)Width || y < 0 || y >= (s32)Height)
 			return;
 
+		Touch({ x, y, 1, 1 });
 		if (PixelSize == 1)
-			*(PixelA + y * Width + x) = color;
+			*(GetRow(y) + x) = color;
 		else
-			*(PixelBGRA + y * Width + x) = color;
+			*(GetRowBGRA(y) + x) = color;
 	}
 
 	u32 GetPixel(s32 x, s32 y) const
 	{
+		if (Tiles && Tiles->Flagged && (Tiles->Flags[(y >> BitmapTiles::TileShift) * Tiles->TilesX + (x >> BitmapTiles::TileShift)] & BitmapTiles::TILE_CLEAR_PENDING))
+			return Tiles->ClearColor;
 		if (PixelSize == 4)
-			return *(PixelBGRA + y * Width + x);
-		return *(PixelA + y * Width + x);
+			return *(GetRowBGRA(y) + x);
+		return *(GetRow(y) + x);
 	}
 
 	u32 GetTexel(float u, float v) const
@@ -58,8 +146,8 @@ struct Bitmap
 		s32 x = (s32)(u * Width) & (Width-1);
 		s32 y = (s32)(v * Height) & (Height - 1);
 		if (PixelSize == 4)
-			return *(PixelBGRA + y * Width + x);
-		return *(PixelA + y * Width + x);
+			return *(GetRowBGRA(y) + x);
+		return *(GetRow(y) + x);
 	}
 
 	bool ClipLine(s32& x1, s32& y1, s32& x2, s32& y2, Rect clipRect);
@@ -71,14 +159,15 @@ struct Bitmap
 			if (x1 > x2)
 				Jogo::swap(x1, x2);
 
+			Touch({ x1, y, x2 - x1 + 1, 1 });
 			if (PixelSize == 1)
 			{
-				u8* row = PixelA + y * Width + x1;
+				u8* row = GetRow(y) + x1;
 				__stosb(row, (u8)color, (size_t)(x2 - x1 + 1));
 			}
 			else
 			{
-				u32* row = PixelBGRA + y * Width + x1;
+				u32* row = GetRowBGRA(y) + x1;
 				__stosd((unsigned long*)row, color, (size_t)(x2 - x1 + 1));
 			}
 		}
@@ -88,22 +177,22 @@ struct Bitmap
 	{
 		if (ClipLine(x, y1, x, y2, { 0,0,(s32)Width,(s32)Height }))
 		{
+			Touch({ x, y1, 1, y2 - y1 + 1 });
+			u8* Row = GetRow(y1);
 			if (PixelSize == 1)
 			{
-				u8* Pixel = PixelA + y1 * Width + x;
 				for (s32 y = y1; y <= y2; y++)
 				{
-					*Pixel = color;
-					Pixel += Width;
+					Row[x] = color;
+					Row += Pitch;
 				}
 			}
 			else
 			{
-				u32* Pixel = PixelBGRA + y1 * Width + x;
 				for (s32 y = y1; y <= y2; y++)
 				{
-					*Pixel = color;
-					Pixel += Width;
+					((u32*)Row)[x] = color;
+					Row += Pitch;
 				}
 			}
 		}
@@ -272,10 +361,23 @@ struct Bitmap
 	void FillTriangleTexLitInt(const VertexTexLit& a, const VertexTexLit& b, const VertexTexLit& c, const Bitmap& texture);
 
 	static Bitmap Load(const char* filename, Arena& arena);
-	static Bitmap Create(u32 Width, u32 Height, u32 PixelSize, Arena& arena)
+
+	// Aligned pads every row out to RowAlignment bytes and starts the first one on that boundary
+	static Bitmap Create(u32 Width, u32 Height, u32 PixelSize, Arena& arena, bool Aligned = false)
 	{
-		Bitmap bitmap = { Width, Height, PixelSize };
-		bitmap.Pixels = arena.Allocate(Width * Height *PixelSize);
+		Bitmap bitmap = { Width, Height, PixelSize, Width * PixelSize };
+		if (!Aligned)
+		{
+			bitmap.Pixels = arena.Allocate(Width * Height * PixelSize);
+			return bitmap;
+		}
+
+		bitmap.Pitch = (bitmap.Pitch + RowAlignment - 1) & ~(RowAlignment - 1);
+		u8* Block = (u8*)arena.Allocate((size_t)bitmap.Pitch * Height + RowAlignment - 1);
+		if (Block)
+		{
+			bitmap.Pixels = (void*)(((size_t)Block + RowAlignment - 1) & ~(size_t)(RowAlignment - 1));
+		}
 		return bitmap;
 	}
 };
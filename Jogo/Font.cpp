@@ -2,6 +2,13 @@
 #include "Arena.h"
 #include "Font.h"
 
+// the older .fnt files only ever set FONT_FIXED_WIDTH, as a plain 1
+enum FontFlags : u32
+{
+	FONT_FIXED_WIDTH = 1,
+	FONT_ANTIALIASED = 2,	// the bitmap is 0-255 coverage, see Font::Antialiased
+};
+
 Font Font::Load(const char* filename, Arena& arena)
 {
 	struct FontHeader
@@ -10,7 +17,7 @@ Font Font::Load(const char* filename, Arena& arena)
 		u32 CharacterCount;
 		u32 CharacterWidth;
 		u32 CharacterHeight;
-		u32 FixedWidth;
+		u32 Flags;
 		const char BitmapFilename[32] = {};
 	} FontFileHeader;
 
@@ -23,7 +30,8 @@ Font Font::Load(const char* filename, Arena& arena)
 		LoadedFont.CharacterCount = FontFileHeader.CharacterCount;
 		LoadedFont.CharacterWidth = FontFileHeader.CharacterWidth;
 		LoadedFont.CharacterHeight = FontFileHeader.CharacterHeight;
-		if (!FontFileHeader.FixedWidth)
+		LoadedFont.Antialiased = (FontFileHeader.Flags & FONT_ANTIALIASED) != 0;
+		if (!(FontFileHeader.Flags & FONT_FIXED_WIDTH))
 		{
 			LoadedFont.CharacterRects = (Bitmap::Rect*)arena.Allocate(FontFileHeader.CharacterCount * sizeof(Bitmap::Rect));
 			fread(LoadedFont.CharacterRects, sizeof(Bitmap::Rect), FontFileHeader.CharacterCount, fp);
@@ -27,6 +27,7 @@ struct Font {
 	u32 CharacterHeight;
 	Bitmap::Rect* CharacterRects;
 	Bitmap FontBitmap;
+	bool Antialiased;		// FontBitmap holds 0-255 coverage rather than a 0 / non 0 mask, set by the .fnt's flags
 
 	Bitmap::Rect GetTextSize(const Jogo::str8& Text)
 	{
@@ -105,7 +106,23 @@ struct Font {
 		}
 	}
 
-	// TODO: Add support for BGRA fonts and anti-aliased alpha fonts
+	// unscaled glyphs of an antialiased font are blended over the background, or over bkcolor when it has alpha
+	void PasteGlyph(s32 x, s32 y, const Bitmap::Rect& Glyph, u32 color, u32 bkcolor, Bitmap& destination)
+	{
+		if (!Antialiased)
+		{
+			destination.PasteBitmapSelection(x, y, FontBitmap, Glyph, color, bkcolor);
+			return;
+		}
+
+		if (bkcolor & 0xff000000)
+		{
+			destination.FillRect({ x, y, Glyph.w, Glyph.h }, bkcolor);
+		}
+		destination.PasteBitmapBlend(x, y, FontBitmap, Glyph, Bitmap::BLEND_OVER, color);
+	}
+
+	// TODO: Add support for BGRA fonts
 	void DrawText(s32 x, s32 y, const Jogo::str8& Text, u32 color, u32 bkcolor, Bitmap destination, s32 scale = 1)
 	{
 		// FixedWidth Font - assume characters are packed Bitmap.Width / Font.CharacterWidth per row
@@ -122,9 +139,15 @@ struct Font {
 				s32 sx = (c % CharactersPerRow) * CharacterWidth;
 				s32 sy = (c / CharactersPerRow) * CharacterHeight;
 
-				destination.PasteBitmapSelectionScaled({ cursor, y, DestWidth, DestHeight }, FontBitmap, { sx, sy, (s32)CharacterWidth, (s32)CharacterHeight }, color, bkcolor);
-				//	destination.PasteBitmapSelection( cursor, y, FontBitmap, { sx, sy, (s32)CharacterWidth, (s32)CharacterHeight }, color);
-				//	Jogo::Show(destination.PixelBGRA, destination.Width, destination.Height);
+				// unscaled text is most of it, and the straight paste has the vector kernels
+				if (scale == 1)
+				{
+					PasteGlyph(cursor, y, { sx, sy, (s32)CharacterWidth, (s32)CharacterHeight }, color, bkcolor, destination);
+				}
+				else
+				{
+					destination.PasteBitmapSelectionScaled({ cursor, y, DestWidth, DestHeight }, FontBitmap, { sx, sy, (s32)CharacterWidth, (s32)CharacterHeight }, color, bkcolor);
+				}
 			}
 		}
 		else
@@ -136,7 +159,7 @@ struct Font {
 				u8 c = *p - CharacterMin;
 				if (c > 0 && c < CharacterCount)
 				{
-					destination.PasteBitmapSelection(cursor, y, FontBitmap, CharacterRects[c], color);
+					PasteGlyph(cursor, y, CharacterRects[c], color, 0, destination);
 				}
 			}
 		}
@@ -0,0 +1,213 @@
+#pragma once
+#include "int_types.h"
+#include "Arena.h"
+#include "str8.h"
+
+namespace Jogo
+{
+	// 0 marks an empty slot in HashMap, so no key may hash to it
+	inline u32 HashKey(u64 Key)
+	{
+		// murmur3's finaliser
+		Key ^= Key >> 33;
+		Key *= 0xff51afd7ed558ccdull;
+		Key ^= Key >> 33;
+		Key *= 0xc4ceb9fe1a85ec53ull;
+		Key ^= Key >> 33;
+		u32 Hash = (u32)Key;
+		return Hash ? Hash : 1;
+	}
+
+	inline u32 HashKey(const str8& Key)
+	{
+		// FNV-1a
+		u32 Hash = 2166136261u;
+		for (size_t i = 0; i < Key.len; i++)
+		{
+			Hash = (Hash ^ (u8)Key.chars[i]) * 16777619u;
+		}
+		return Hash ? Hash : 1;
+	}
+
+	inline bool KeysEqual(u64 a, u64 b)
+	{
+		return a == b;
+	}
+
+	inline bool KeysEqual(const str8& a, const str8& b)
+	{
+		return a.len == b.len && (a.chars == b.chars || !memcmp(a.chars, b.chars, a.len));
+	}
+
+	// open addressing with linear probing, keyed by u64 or str8, living in an Arena
+	// the hashes are kept in their own array so a probe walks 4 bytes a slot until it finds its hash
+	// removal shifts the rest of the probe run back instead of leaving tombstones
+	// str8 keys are stored as given, so their characters have to outlive the map, intern them if they don't
+	// growing rehashes into new arrays twice the size and leaves the old ones in the arena
+	template<typename K, typename V>
+	struct HashMap
+	{
+		u32* Hashes;
+		K* Keys;
+		V* Values;
+		u32 Count;
+		u32 Capacity;		// power of 2
+		Arena* Memory;
+
+		static HashMap Create(Arena& Memory, u32 InitialCapacity = 16)
+		{
+			HashMap NewMap = {};
+			NewMap.Memory = &Memory;
+			u32 Capacity = 16;
+			while (Capacity < InitialCapacity)
+			{
+				Capacity *= 2;
+			}
+			NewMap.Allocate(Capacity);
+			return NewMap;
+		}
+
+		V* Find(const K& Key)
+		{
+			if (!Capacity)
+				return nullptr;
+
+			u32 Hash = HashKey(Key);
+			u32 Mask = Capacity - 1;
+			for (u32 i = Hash & Mask; Hashes[i]; i = (i + 1) & Mask)
+			{
+				if (Hashes[i] == Hash && KeysEqual(Keys[i], Key))
+					return &Values[i];
+			}
+			return nullptr;
+		}
+
+		// the value for Key, added uninitialised if it wasn't there, nullptr if the arena is full
+		V* FindOrAdd(const K& Key, bool* Added = nullptr)
+		{
+			if (Added)
+			{
+				*Added = false;
+			}
+
+			// grow at 3/4 full, past that the probe runs get long
+			if ((Count + 1) * 4 > Capacity * 3 && !Grow())
+				return nullptr;
+
+			u32 Hash = HashKey(Key);
+			u32 Mask = Capacity - 1;
+			u32 i = Hash & Mask;
+			for (; Hashes[i]; i = (i + 1) & Mask)
+			{
+				if (Hashes[i] == Hash && KeysEqual(Keys[i], Key))
+					return &Values[i];
+			}
+
+			Hashes[i] = Hash;
+			Keys[i] = Key;
+			Count++;
+			if (Added)
+			{
+				*Added = true;
+			}
+			return &Values[i];
+		}
+
+		bool Insert(const K& Key, const V& Value)
+		{
+			V* Slot = FindOrAdd(Key);
+			if (!Slot)
+				return false;
+			*Slot = Value;
+			return true;
+		}
+
+		bool Remove(const K& Key)
+		{
+			if (!Capacity)
+				return false;
+
+			u32 Hash = HashKey(Key);
+			u32 Mask = Capacity - 1;
+			u32 i = Hash & Mask;
+			for (; Hashes[i]; i = (i + 1) & Mask)
+			{
+				if (Hashes[i] == Hash && KeysEqual(Keys[i], Key))
+					break;
+			}
+			if (!Hashes[i])
+				return false;
+
+			// pull back every later entry in the run that would be unreachable across the hole
+			for (u32 j = (i + 1) & Mask; Hashes[j]; j = (j + 1) & Mask)
+			{
+				u32 Home = Hashes[j] & Mask;
+				if (((j - Home) & Mask) >= ((j - i) & Mask))
+				{
+					Hashes[i] = Hashes[j];
+					Keys[i] = Keys[j];
+					Values[i] = Values[j];
+					i = j;
+				}
+			}
+			Hashes[i] = 0;
+			Count--;
+			return true;
+		}
+
+		void Clear()
+		{
+			memset(Hashes, 0, Capacity * sizeof(u32));
+			Count = 0;
+		}
+
+		// for walking every entry: for (u32 i = 0; i < Map.Capacity; i++) if (Map.IsUsed(i)) ...
+		bool IsUsed(u32 Slot) const
+		{
+			return Hashes[Slot] != 0;
+		}
+
+		bool Allocate(u32 NewCapacity)
+		{
+			u32* NewHashes = (u32*)Memory->Allocate(NewCapacity * sizeof(u32));
+			K* NewKeys = (K*)Memory->Allocate(NewCapacity * sizeof(K));
+			V* NewValues = (V*)Memory->Allocate(NewCapacity * sizeof(V));
+			if (!NewHashes || !NewKeys || !NewValues)
+				return false;
+
+			memset(NewHashes, 0, NewCapacity * sizeof(u32));
+			Hashes = NewHashes;
+			Keys = NewKeys;
+			Values = NewValues;
+			Capacity = NewCapacity;
+			return true;
+		}
+
+		bool Grow()
+		{
+			u32* OldHashes = Hashes;
+			K* OldKeys = Keys;
+			V* OldValues = Values;
+			u32 OldCapacity = Capacity;
+			if (!Allocate(OldCapacity ? OldCapacity * 2 : 16))
+				return false;
+
+			u32 Mask = Capacity - 1;
+			for (u32 j = 0; j < OldCapacity; j++)
+			{
+				if (!OldHashes[j])
+					continue;
+
+				u32 i = OldHashes[j] & Mask;
+				while (Hashes[i])
+				{
+					i = (i + 1) & Mask;
+				}
+				Hashes[i] = OldHashes[j];
+				Keys[i] = OldKeys[j];
+				Values[i] = OldValues[j];
+			}
+			return true;
+		}
+	};
+};
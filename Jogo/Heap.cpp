@@ -0,0 +1,192 @@
+#include "Jogo.h"
+#include "Heap.h"
+#include <string.h>
+
+namespace Jogo
+{
+	namespace Heap
+	{
+		static const size_t ReserveSize = 16ull * 1024 * 1024 * 1024;
+		static const u32 MaxSlabs = (u32)(ReserveSize / SlabSize);
+		static const u32 CacheBatch = 16;
+
+		struct ThreadCache
+		{
+			u32 Count[NumClasses];
+			FreeListAllocator::FreeBlock* Lists[NumClasses];
+
+			// counted here and added to the heap's stats whenever the cache takes the lock
+			s64 Allocs[NumClasses];
+			s64 Frees[NumClasses];
+		};
+
+		thread_local ThreadCache Cache;
+
+		SpinLock Lock;
+		u8* Base = nullptr;
+		u32 NumSlabs = 0;
+		u8 SlabClass[MaxSlabs];
+		FreeListAllocator::FreeBlock* FreeLists[NumClasses];
+		Stats HeapStats;
+		volatile s64 LargeAllocs = 0;
+		volatile s64 LargeFrees = 0;
+
+		// call with the lock held
+		static bool CutSlab(u32 SizeClass)
+		{
+			if (!Base)
+			{
+				Base = (u8*)Reserve(ReserveSize);
+				if (!Base)
+					return false;
+			}
+			if (NumSlabs == MaxSlabs)
+				return false;
+
+			u8* Slab = Base + (size_t)NumSlabs * SlabSize;
+			if (!Commit(Slab, SlabSize))
+				return false;
+
+			size_t BlockSize = FreeListAllocator::GetClassSize(SizeClass);
+			u32 Count = (u32)(SlabSize / BlockSize);
+			for (u32 i = Count; i-- > 0;)
+			{
+				FreeListAllocator::FreeBlock* Block = (FreeListAllocator::FreeBlock*)(Slab + i * BlockSize);
+				Block->Next = FreeLists[SizeClass];
+				FreeLists[SizeClass] = Block;
+			}
+			SlabClass[NumSlabs++] = (u8)SizeClass;
+			HeapStats.Classes[SizeClass].Carved += Count;
+			HeapStats.Slabs = NumSlabs;
+			return true;
+		}
+
+		// call with the lock held
+		static void MergeCacheStats(u32 SizeClass)
+		{
+			PoolStats& s = HeapStats.Classes[SizeClass];
+			s.Allocs += Cache.Allocs[SizeClass];
+			s.Frees += Cache.Frees[SizeClass];
+
+			// a thread can free blocks another allocated before that one's count is merged, so the totals can
+			// briefly say more were freed than allocated
+			s64 Live = (s64)(s.Allocs - s.Frees);
+			s.Live = Live > 0 ? (u32)Live : 0;
+			s.Peak = max(s.Peak, s.Live);
+			Cache.Allocs[SizeClass] = 0;
+			Cache.Frees[SizeClass] = 0;
+		}
+
+		static void* AllocateSmall(size_t Size)
+		{
+			u32 c = FreeListAllocator::GetSizeClass(Size);
+			if (!Cache.Lists[c])
+			{
+				Lock.Lock();
+				MergeCacheStats(c);
+				for (u32 i = 0; i < CacheBatch && (FreeLists[c] || CutSlab(c)); i++)
+				{
+					FreeListAllocator::FreeBlock* Block = FreeLists[c];
+					FreeLists[c] = Block->Next;
+					Block->Next = Cache.Lists[c];
+					Cache.Lists[c] = Block;
+					Cache.Count[c]++;
+				}
+				Lock.Unlock();
+				if (!Cache.Lists[c])
+					return nullptr;
+			}
+
+			FreeListAllocator::FreeBlock* Result = Cache.Lists[c];
+			Cache.Lists[c] = Result->Next;
+			Cache.Count[c]--;
+			Cache.Allocs[c]++;
+
+			// OS pages always came back zeroed and callers count on it
+			memset(Result, 0, Size);
+			return Result;
+		}
+
+		static void FreeSmall(void* Memory, u32 SizeClass)
+		{
+			FreeListAllocator::FreeBlock* Freed = (FreeListAllocator::FreeBlock*)Memory;
+			Freed->Next = Cache.Lists[SizeClass];
+			Cache.Lists[SizeClass] = Freed;
+			Cache.Frees[SizeClass]++;
+
+			// keep one batch in hand so alternating Allocate and Free doesn't bounce on the lock
+			if (++Cache.Count[SizeClass] >= CacheBatch * 2)
+			{
+				Lock.Lock();
+				MergeCacheStats(SizeClass);
+				for (u32 i = 0; i < CacheBatch; i++)
+				{
+					FreeListAllocator::FreeBlock* Returned = Cache.Lists[SizeClass];
+					Cache.Lists[SizeClass] = Returned->Next;
+					Returned->Next = FreeLists[SizeClass];
+					FreeLists[SizeClass] = Returned;
+				}
+				Cache.Count[SizeClass] -= CacheBatch;
+				Lock.Unlock();
+			}
+		}
+
+		void FlushThreadCache()
+		{
+			Lock.Lock();
+			for (u32 c = 0; c < NumClasses; c++)
+			{
+				MergeCacheStats(c);
+				while (FreeListAllocator::FreeBlock* Returned = Cache.Lists[c])
+				{
+					Cache.Lists[c] = Returned->Next;
+					Returned->Next = FreeLists[c];
+					FreeLists[c] = Returned;
+				}
+				Cache.Count[c] = 0;
+			}
+			Lock.Unlock();
+		}
+
+		Stats GetStats()
+		{
+			Lock.Lock();
+			for (u32 c = 0; c < NumClasses; c++)
+			{
+				MergeCacheStats(c);
+				HeapStats.Classes[c].BlockSize = FreeListAllocator::GetClassSize(c);
+			}
+			Stats Result = HeapStats;
+			Lock.Unlock();
+			Result.LargeAllocs = (u64)LargeAllocs;
+			Result.LargeFrees = (u64)LargeFrees;
+			return Result;
+		}
+	};
+
+	void* Allocate(size_t Size)
+	{
+		if (Size <= Heap::MaxSmallSize)
+			return Heap::AllocateSmall(Size);
+
+		AtomicAdd64(&Heap::LargeAllocs, 1);
+		return AllocatePages(Size);
+	}
+
+	void Free(void* Memory)
+	{
+		if (!Memory)
+			return;
+
+		// anything inside the heap's range is a block, its slab knows its size
+		size_t Offset = (size_t)((u8*)Memory - Heap::Base);
+		if (Heap::Base && Offset < Heap::ReserveSize)
+		{
+			Heap::FreeSmall(Memory, Heap::SlabClass[Offset / Heap::SlabSize]);
+			return;
+		}
+
+		AtomicAdd64(&Heap::LargeFrees, 1);
+		FreePages(Memory);
+	}
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include "int_types.h"
+#include "Pool.h"
+
+namespace Jogo
+{
+	// what's behind Jogo::Allocate and Free
+	// anything up to MaxSmallSize comes from a size class, 16 bytes up in steps of half a power of 2, whose blocks
+	// are cut from 64KB slabs in one reserved range, so the slab a block is in says its size and Free needs no header
+	// each thread keeps a short list per class and only takes the heap's lock to move a batch at a time
+	// slabs stay with their class once cut, so the heap holds on to its peak; bigger requests go to AllocatePages
+	namespace Heap
+	{
+		static const size_t MaxSmallSize = 32 * 1024;
+		static const size_t SlabSize = 64 * 1024;
+		static const u32 NumClasses = 23;		// FreeListAllocator's classes, carried on up to MaxSmallSize
+
+		struct Stats
+		{
+			PoolStats Classes[NumClasses];
+			u32 Slabs;			// cut so far
+			u64 LargeAllocs;
+			u64 LargeFrees;
+		};
+
+		// approximate while other threads allocate: their counts are only merged in as of the last time each took
+		// the lock, anything they allocated or freed since then is missing
+		Stats GetStats();
+
+		// hands this thread's cached blocks back, every Thread does it when its function returns
+		void FlushThreadCache();
+	};
+};
@@ -0,0 +1,220 @@
+#include "Jogo.h"
+#include "Input.h"
+
+namespace Input
+{
+	// single producer, single consumer ring, Head is only written by the producer and Tail by the consumer
+	struct EventQueue
+	{
+		static const u32 Size = 1024;	// power of 2
+
+		Event Events[Size];
+		volatile u32 Head;
+		u8 Pad[60];
+		volatile u32 Tail;
+
+		bool Push(const Event& NewEvent)
+		{
+			u32 h = Head;
+			if (h - Tail >= Size)
+				return false;
+
+			Events[h & (Size - 1)] = NewEvent;
+			Jogo::CompilerBarrier();
+			Head = h + 1;
+			return true;
+		}
+
+		bool Pop(Event& OutEvent)
+		{
+			u32 t = Tail;
+			if (t == Head)
+				return false;
+
+			Jogo::CompilerBarrier();
+			OutEvent = Events[t & (Size - 1)];
+			Jogo::CompilerBarrier();
+			Tail = t + 1;
+			return true;
+		}
+	};
+
+	EventQueue Queue;
+	InputState State;
+	u32 DroppedEvents = 0;
+	EventHook* CurrentHook = nullptr;
+
+	void SetEventHook(EventHook* Hook)
+	{
+		CurrentHook = Hook;
+	}
+
+	void PostEvent(EventType Type, s32 Value, s32 x, s32 y)
+	{
+		Event NewEvent = { Jogo::Timer::GetTicks(), Type, Value, x, y };
+
+		// a full queue means nobody has run a frame for a long time, losing a key up then is the least of it
+		if (!Queue.Push(NewEvent))
+		{
+			DroppedEvents++;
+		}
+		Jogo::RequestRedraw();
+	}
+
+	const InputState& GetState()
+	{
+		return State;
+	}
+
+	static void SetKey(s32 key, bool Down)
+	{
+		u32 Word = (key >> 5) & 7;
+		u32 Bit = 1u << (key & 31);
+		if (Down)
+		{
+			State.Down[Word] |= Bit;
+			State.Pressed[Word] |= Bit;
+		}
+		else
+		{
+			State.Down[Word] &= ~Bit;
+			State.Released[Word] |= Bit;
+		}
+	}
+
+	static void Apply(const Event& e)
+	{
+		switch (e.Type)
+		{
+		case EVENT_KEY_DOWN:
+			SetKey(e.Value, true);
+			break;
+		case EVENT_KEY_UP:
+			SetKey(e.Value, false);
+			break;
+		case EVENT_MOUSE_DOWN:
+		case EVENT_MOUSE_DOUBLE_CLICK:	// the second press of a double click only comes as this
+			SetKey(e.Value, true);
+			State.MouseX = e.x;
+			State.MouseY = e.y;
+			break;
+		case EVENT_MOUSE_UP:
+			SetKey(e.Value, false);
+			State.MouseX = e.x;
+			State.MouseY = e.y;
+			break;
+		case EVENT_MOUSE_MOVE:
+			State.MouseX = e.x;
+			State.MouseY = e.y;
+			break;
+		case EVENT_MOUSE_WHEEL:
+			State.Wheel += e.Value;
+			break;
+		case EVENT_FOCUS_LOST:
+			for (u32 i = 0; i < 8; i++)
+			{
+				State.Released[i] |= State.Down[i];
+				State.Down[i] = 0;
+			}
+			break;
+		default:
+			break;
+		}
+		State.LastEventTime = e.Time;
+		State.NumEvents++;
+	}
+
+	static void Dispatch(const Event& e, InputHandler* UIHandler, InputHandler* AppHandler)
+	{
+		Keys key = (Keys)e.Value;
+		switch (e.Type)
+		{
+		case EVENT_KEY_DOWN:
+			if (!UIHandler || !UIHandler->KeyDown(key))
+			{
+				if (AppHandler)
+					AppHandler->KeyDown(key);
+			}
+			break;
+		case EVENT_KEY_UP:
+			if (AppHandler)
+				AppHandler->KeyUp(key);
+			break;
+		case EVENT_CHAR:
+			if (!UIHandler || !UIHandler->Char((char)e.Value))
+			{
+				if (AppHandler)
+					AppHandler->Char((char)e.Value);
+			}
+			break;
+		case EVENT_MOUSE_DOWN:
+			if (!UIHandler || !UIHandler->MouseDown(e.x, e.y, key))
+			{
+				if (AppHandler)
+					AppHandler->MouseDown(e.x, e.y, key);
+			}
+			break;
+		case EVENT_MOUSE_UP:
+			if (!UIHandler || !UIHandler->MouseUp(e.x, e.y, key))
+			{
+				if (AppHandler)
+					AppHandler->MouseUp(e.x, e.y, key);
+			}
+			break;
+		case EVENT_MOUSE_DOUBLE_CLICK:
+			if (!UIHandler || !UIHandler->MouseDoubleClick(e.x, e.y, key))
+			{
+				if (AppHandler)
+					AppHandler->MouseDoubleClick(e.x, e.y, key);
+			}
+			break;
+		case EVENT_MOUSE_MOVE:
+			if (AppHandler)
+				AppHandler->MouseMove(e.x, e.y);
+			break;
+		case EVENT_MOUSE_WHEEL:
+			if (AppHandler)
+				AppHandler->MouseWheel(e.Value);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void BeginFrame(InputHandler* UIHandler, InputHandler* AppHandler)
+	{
+		for (u32 i = 0; i < 8; i++)
+		{
+			State.Pressed[i] = 0;
+			State.Released[i] = 0;
+		}
+		State.Wheel = 0;
+		State.NumEvents = 0;
+
+		// only what was queued when the frame started, a busy producer can't hold the frame up
+		// handlers run after their event is applied, so polling from one sees the state as of that event
+		u32 Count = Queue.Head - Queue.Tail;
+		Event e;
+		for (u32 i = 0; i < Count && Queue.Pop(e); i++)
+		{
+			if (CurrentHook)
+			{
+				CurrentHook(e);
+			}
+			Apply(e);
+			Dispatch(e, UIHandler, AppHandler);
+		}
+		State.FrameTime = Jogo::Timer::GetTicks();
+	}
+
+	bool IsKeyPressed(int key)
+	{
+		return State.IsDown(key);
+	}
+
+	void GetMousePos(int& x, int& y)
+	{
+		x = State.MouseX;
+		y = State.MouseY;
+	}
+};
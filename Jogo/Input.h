@@ -42,6 +42,59 @@ namespace Input
 		virtual bool MouseWheel(s32 wheelScroll) { return false; }
 	};
 
+	// the platform layer, or any other single producer thread, posts events into a lock-free queue
+	// Run drains it once at the top of the frame, before Tick, updating the snapshot and calling the handlers
+	enum EventType : u32
+	{
+		EVENT_KEY_DOWN,
+		EVENT_KEY_UP,
+		EVENT_CHAR,
+		EVENT_MOUSE_DOWN,
+		EVENT_MOUSE_UP,
+		EVENT_MOUSE_DOUBLE_CLICK,
+		EVENT_MOUSE_MOVE,
+		EVENT_MOUSE_WHEEL,
+		EVENT_FOCUS_LOST,	// releases every key and button
+	};
+
+	struct Event
+	{
+		u64 Time;		// Jogo::Timer ticks
+		EventType Type;
+		s32 Value;		// key, char, button or wheel delta
+		s32 x;
+		s32 y;
+	};
+
+	void PostEvent(EventType Type, s32 Value = 0, s32 x = 0, s32 y = 0);
+
+	// sees every event as BeginFrame takes it off the queue, for the recorder
+	typedef void EventHook(const Event& e);
+	void SetEventHook(EventHook* Hook);
+
+	// everything the app can poll, fixed for the frame once the queue has been drained
+	struct InputState
+	{
+		u32 Down[8];		// bit per key code, mouse buttons are keys 1, 2 and 4
+		u32 Pressed[8];		// went down this frame
+		u32 Released[8];	// went up this frame
+		s32 MouseX;
+		s32 MouseY;
+		s32 Wheel;			// total this frame
+		u32 NumEvents;		// this frame
+		u64 FrameTime;		// when the snapshot was taken
+		u64 LastEventTime;
+
+		bool IsDown(int key) const { return (Down[(key >> 5) & 7] >> (key & 31)) & 1; }
+		bool WasPressed(int key) const { return (Pressed[(key >> 5) & 7] >> (key & 31)) & 1; }
+		bool WasReleased(int key) const { return (Released[(key >> 5) & 7] >> (key & 31)) & 1; }
+	};
+
+	const InputState& GetState();
+
+	// called by Jogo::Run, the UI handler sees key, char and button events first and the app gets what it doesn't take
+	void BeginFrame(InputHandler* UIHandler, InputHandler* AppHandler);
+
 	// input
 	bool IsKeyPressed(int key);
 	void GetMousePos(int& x, int& y);
@@ -0,0 +1,50 @@
+#include "Jogo.h"
+#include "Intern.h"
+
+namespace Jogo
+{
+	Interner Interner::Create(Arena& Memory, u32 InitialCapacity)
+	{
+		Interner NewInterner = {};
+		NewInterner.Memory = &Memory;
+		NewInterner.Lookup = HashMap<str8, u32>::Create(Memory, InitialCapacity);
+		NewInterner.Strings = Array<str8>::Create(Memory, InitialCapacity);
+		return NewInterner;
+	}
+
+	u32 Interner::GetID(const str8& String)
+	{
+		bool Added;
+		u32* ID = Lookup.FindOrAdd(String, &Added);
+		if (!ID)
+			return (u32)-1;
+		if (!Added)
+			return *ID;
+
+		// make room for the ID first and double like Add would, the characters are allocated after it, so the
+		// array is never on top of the arena to grow in place and growing by one would copy it every time
+		bool Room = Strings.Count < Strings.Capacity || Strings.Reserve(Strings.Capacity ? Strings.Capacity * 2 : 16);
+
+		// the map is holding the caller's characters, swap in a copy of our own
+		char* Chars = Room ? (char*)Memory->Allocate(String.len + 1) : nullptr;
+		if (!Chars)
+		{
+			Lookup.Remove(String);
+			return (u32)-1;
+		}
+		str8::copystring(String.chars, Chars, String.len, String.len);
+		Chars[String.len] = 0;
+
+		str8 Copy(Chars, String.len);
+		Lookup.Keys[ID - Lookup.Values] = Copy;
+		*ID = Strings.Count;
+		Strings.Add(Copy);
+		return *ID;
+	}
+
+	str8 Interner::Intern(const str8& String)
+	{
+		u32 ID = GetID(String);
+		return ID == (u32)-1 ? str8("") : Strings[ID];
+	}
+};
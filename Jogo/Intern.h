@@ -0,0 +1,26 @@
+#pragma once
+#include "int_types.h"
+#include "Array.h"
+#include "HashMap.h"
+
+namespace Jogo
+{
+	// keeps one copy of every distinct string, so two interned str8s are equal exactly when their chars are,
+	// and an ID is a small dense number for tables such as symbol names
+	// the copies are null terminated and live as long as the arena
+	struct Interner
+	{
+		HashMap<str8, u32> Lookup;
+		Array<str8> Strings;		// by ID
+		Arena* Memory;
+
+		static Interner Create(Arena& Memory, u32 InitialCapacity = 256);
+
+		// the interned copy, made the first time these characters are seen
+		str8 Intern(const str8& String);
+
+		// IDs count up from 0 in the order strings were first interned, (u32)-1 if the arena is full
+		u32 GetID(const str8& String);
+		str8 GetString(u32 ID) const { return Strings[ID]; }
+	};
+};
@@ -1,6 +1,6 @@
 #pragma once
 #include "int_types.h"
-#include <intrin.h>
+#include "Platform.h"
 
 namespace Jogo
 {
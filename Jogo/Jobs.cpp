@@ -0,0 +1,351 @@
+#include "Jogo.h"
+#include "Jobs.h"
+
+namespace Jogo
+{
+	namespace Jobs
+	{
+		struct Job
+		{
+			JobFunction* Function;
+			void* Data;
+			u32 Begin;
+			u32 End;
+			Counter* Done;
+			Counter* Dependency;
+		};
+
+		// Chase-Lev work-stealing deque: the owner pushes and pops at Bottom, thieves take from Top
+		struct Deque
+		{
+			static const s64 Capacity = 4096;	// power of 2
+
+			volatile s64 Top;
+			u8 Pad[64];
+			volatile s64 Bottom;
+			Job Jobs[Capacity];
+
+			bool Push(const Job& NewJob)
+			{
+				s64 b = Bottom;
+				if (b - Top >= Capacity)
+					return false;
+
+				Jobs[b & (Capacity - 1)] = NewJob;
+				CompilerBarrier();
+				Bottom = b + 1;
+				return true;
+			}
+
+			bool Pop(Job& OutJob)
+			{
+				s64 b = Bottom - 1;
+				Bottom = b;
+				AtomicFence();
+				s64 t = Top;
+				if (t > b)
+				{
+					Bottom = t;
+					return false;
+				}
+
+				OutJob = Jobs[b & (Capacity - 1)];
+				if (t != b)
+					return true;
+
+				// last job, race the thieves for it
+				bool Won = AtomicCompareExchange64(&Top, t, t + 1);
+				Bottom = t + 1;
+				return Won;
+			}
+
+			bool Steal(Job& OutJob)
+			{
+				s64 t = Top;
+				AtomicFence();
+				s64 b = Bottom;
+				if (t >= b)
+					return false;
+
+				OutJob = Jobs[t & (Capacity - 1)];
+				return AtomicCompareExchange64(&Top, t, t + 1);
+			}
+		};
+
+		struct Worker
+		{
+			Deque Queue;
+			Arena FrameArena;
+			Thread WorkerThread;
+			u32 Index;
+		};
+
+		const u32 MaxWorkers = 64;
+		Worker* Workers = nullptr;
+		u32 NumWorkers = 0;
+		volatile s32 Running = 0;
+		volatile s32 Sleeping = 0;
+		Semaphore WakeUp;
+		Arena SerialArena;
+		ConcurrentArena SharedArena;
+		// MaxWorkers on any thread that isn't the one that called Init or one of the workers
+		thread_local u32 WorkerIndex = MaxWorkers;
+
+		static bool OnWorkerThread()
+		{
+			return Running && WorkerIndex < NumWorkers;
+		}
+
+		static bool GetJob(u32 Index, Job& OutJob)
+		{
+			if (Workers[Index].Queue.Pop(OutJob))
+				return true;
+
+			for (u32 i = 1; i < NumWorkers; i++)
+			{
+				u32 Victim = (Index + i) % NumWorkers;
+				if (Workers[Victim].Queue.Steal(OutJob))
+					return true;
+			}
+			return false;
+		}
+
+		static void Execute(const Job& job)
+		{
+			// help out with other jobs until the dependency is satisfied
+			if (job.Dependency)
+			{
+				Wait(job.Dependency);
+			}
+			{
+				JOGO_ZONE("Job");
+				job.Function(job.Data, job.Begin, job.End);
+			}
+			if (job.Done)
+			{
+				AtomicAdd(&job.Done->Value, -1);
+			}
+		}
+
+		static void WorkerMain(void* Data)
+		{
+			Worker* Self = (Worker*)Data;
+			WorkerIndex = Self->Index;
+
+			Job job;
+			while (Running)
+			{
+				bool Found = false;
+				for (u32 Spin = 0; Spin < 64 && !Found; Spin++)
+				{
+					Found = GetJob(Self->Index, job);
+					if (!Found)
+						SpinPause();
+				}
+
+				if (!Found)
+				{
+					// announce we are going to sleep, then look once more so a Submit can't slip past
+					AtomicAdd(&Sleeping, 1);
+					Found = GetJob(Self->Index, job);
+					if (!Found && Running)
+					{
+						WakeUp.Wait();
+					}
+					AtomicAdd(&Sleeping, -1);
+				}
+
+				if (Found)
+				{
+					Execute(job);
+				}
+			}
+			ReleaseScratch();
+		}
+
+		void Init(u32 InNumWorkers, size_t WorkerArenaSize)
+		{
+			if (Running)
+				return;
+
+			if (!InNumWorkers)
+			{
+				u32 Cores = GetProcessorCount();
+				InNumWorkers = Cores > 1 ? Cores - 1 : 1;
+			}
+			NumWorkers = min(InNumWorkers + 1, MaxWorkers);
+
+			Workers = (Worker*)Allocate(NumWorkers * sizeof(Worker));
+			if (!Workers || !WakeUp.Create())
+			{
+				Free(Workers);
+				Workers = nullptr;
+				NumWorkers = 0;
+				return;
+			}
+
+			for (u32 i = 0; i < NumWorkers; i++)
+			{
+				Workers[i].Index = i;
+				Workers[i].FrameArena = Arena::Create(WorkerArenaSize);
+			}
+
+			if (!SharedArena.BaseAddress)
+			{
+				SharedArena = ConcurrentArena::Create();
+			}
+
+			Running = 1;
+			WorkerIndex = 0;
+			for (u32 i = 1; i < NumWorkers; i++)
+			{
+				Workers[i].WorkerThread.Start(WorkerMain, &Workers[i]);
+			}
+		}
+
+		void Shutdown()
+		{
+			if (!Running)
+				return;
+
+			Running = 0;
+			AtomicFence();
+			WakeUp.Signal(NumWorkers);
+			for (u32 i = 1; i < NumWorkers; i++)
+			{
+				Workers[i].WorkerThread.Join();
+			}
+			for (u32 i = 0; i < NumWorkers; i++)
+			{
+				Workers[i].FrameArena.ReleaseMemory();
+			}
+			WakeUp.Release();
+			Free(Workers);
+			Workers = nullptr;
+			NumWorkers = 0;
+		}
+
+		bool IsRunning()
+		{
+			return Running != 0;
+		}
+
+		void SubmitRange(JobFunction* Function, void* Data, u32 Begin, u32 End, Counter* Done, Counter* Dependency)
+		{
+			Job NewJob = { Function, Data, Begin, End, Done, Dependency };
+			if (Done)
+			{
+				AtomicAdd(&Done->Value, 1);
+			}
+
+			// no workers, a thread with no queue of its own, or our queue is full, so run it here
+			// each queue takes pushes from its owner only, so another thread can't borrow one
+			if (!OnWorkerThread() || !Workers[WorkerIndex].Queue.Push(NewJob))
+			{
+				Execute(NewJob);
+				return;
+			}
+
+			AtomicFence();
+			if (Sleeping > 0)
+			{
+				WakeUp.Signal(1);
+			}
+		}
+
+		void Submit(JobFunction* Function, void* Data, Counter* Done, Counter* Dependency)
+		{
+			SubmitRange(Function, Data, 0, 1, Done, Dependency);
+		}
+
+		void Wait(Counter* Done)
+		{
+			Job job;
+			while (!Done->IsDone())
+			{
+				if (OnWorkerThread() && GetJob(WorkerIndex, job))
+				{
+					Execute(job);
+				}
+				else
+				{
+					SpinPause();
+				}
+			}
+		}
+
+		void ParallelFor(u32 Count, u32 BatchSize, JobFunction* Function, void* Data)
+		{
+			if (!OnWorkerThread() || Count <= BatchSize)
+			{
+				Function(Data, 0, Count);
+				return;
+			}
+
+			if (!BatchSize)
+			{
+				BatchSize = 1;
+			}
+
+			Counter Done = {};
+			for (u32 Begin = 0; Begin < Count; Begin += BatchSize)
+			{
+				SubmitRange(Function, Data, Begin, min(Begin + BatchSize, Count), &Done);
+			}
+			Wait(&Done);
+		}
+
+		u32 GetWorkerCount()
+		{
+			return Running ? NumWorkers : 1;
+		}
+
+		u32 GetWorkerIndex()
+		{
+			return OnWorkerThread() ? WorkerIndex : 0;
+		}
+
+		bool IsWorkerThread()
+		{
+			return OnWorkerThread();
+		}
+
+		Arena& GetFrameArena()
+		{
+			if (OnWorkerThread())
+				return Workers[WorkerIndex].FrameArena;
+
+			if (!SerialArena.BaseAddress)
+			{
+				SerialArena = Arena::Create(16 * 1024 * 1024);
+			}
+			return SerialArena;
+		}
+
+		ConcurrentArena& GetSharedFrameArena()
+		{
+			// Init makes it before any worker can ask, without workers only this thread is here
+			if (!SharedArena.BaseAddress)
+			{
+				SharedArena = ConcurrentArena::Create();
+			}
+			return SharedArena;
+		}
+
+		void BeginFrame()
+		{
+			for (u32 i = 0; i < NumWorkers; i++)
+			{
+				Workers[i].FrameArena.Clear();
+			}
+			if (SerialArena.BaseAddress)
+			{
+				SerialArena.Clear();
+			}
+			if (SharedArena.BaseAddress)
+			{
+				SharedArena.Clear();
+			}
+		}
+	};
+};
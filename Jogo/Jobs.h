@@ -0,0 +1,52 @@
+#pragma once
+#include "int_types.h"
+#include "Arena.h"
+
+namespace Jogo
+{
+	namespace Jobs
+	{
+		// a job processes the index range [Begin, End), single jobs get [0, 1)
+		typedef void JobFunction(void* Data, u32 Begin, u32 End);
+
+		// counts outstanding jobs, Submit adds one and each finished job takes one away
+		struct Counter
+		{
+			volatile s32 Value;
+
+			bool IsDone() const { return Value <= 0; }
+		};
+
+		// NumWorkers = 0 starts one worker per core besides the calling thread
+		// without Init every job runs immediately on the submitting thread
+		void Init(u32 NumWorkers = 0, size_t WorkerArenaSize = 16 * 1024 * 1024);
+		void Shutdown();
+		bool IsRunning();
+
+		// a job with a Dependency doesn't start until that counter reaches zero
+		// only the thread that called Init and the workers have queues: Submit, SubmitRange and ParallelFor from
+		// any other thread, like a loader thread, run the jobs there and then before returning
+		void Submit(JobFunction* Function, void* Data, Counter* Done = nullptr, Counter* Dependency = nullptr);
+		void SubmitRange(JobFunction* Function, void* Data, u32 Begin, u32 End, Counter* Done = nullptr, Counter* Dependency = nullptr);
+
+		// the calling thread runs queued jobs until Done reaches zero
+		void Wait(Counter* Done);
+
+		// splits [0, Count) into BatchSize ranges and returns when they have all run
+		void ParallelFor(u32 Count, u32 BatchSize, JobFunction* Function, void* Data);
+
+		u32 GetWorkerCount();		// including the main thread
+		u32 GetWorkerIndex();		// 0 on the main thread, and on threads that aren't workers
+		bool IsWorkerThread();		// the thread that called Init or a worker, while the workers are running
+
+		// per-worker scratch that lives until the next BeginFrame, for the main thread and the workers only
+		Arena& GetFrameArena();
+
+		// one arena every worker can allocate from at once, also cleared by BeginFrame
+		// for jobs that fill a shared result, like binning triangles, where per-worker arenas would need stitching
+		ConcurrentArena& GetSharedFrameArena();
+
+		// called by Jogo::Run at the top of every frame, no jobs may be in flight
+		void BeginFrame();
+	};
+};
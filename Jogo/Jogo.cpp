@@ -1,27 +1,61 @@
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <timeapi.h>
+#include <psapi.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
 #include "Jogo.h"
 
 namespace Jogo
 {
 	const char* App::JogoName = "Jogo Default";
 
-	HDC hdc;
-	HWND hwnd;
 	bool Pause = false;
 	Input::InputHandler* UIHandler = nullptr;
 	u32 NumTickHandlers = 0;
 	const u32 MaxTickHandlers = 8;
 	TickHandler* TickHandlers[MaxTickHandlers];
 
+	// the backbuffer's tile flags live on the heap, a resize reuses them while it has no more tiles and otherwise
+	// hands them back for a bigger block, so dragging the window around doesn't pile up copies anywhere
+	static void SizeTiles(BitmapTiles& Tiles, int Width, int Height)
+	{
+		u32 Count = (((u32)Width + BitmapTiles::TileSize - 1) >> BitmapTiles::TileShift) *
+			(((u32)Height + BitmapTiles::TileSize - 1) >> BitmapTiles::TileShift);
+		u8* Flags = Tiles.Flags;
+		u32 Capacity = Tiles.TilesX * Tiles.TilesY;
+		if (Count > Capacity)
+		{
+			Free(Flags);
+			Flags = (u8*)Allocate(Count);
+			Capacity = Flags ? Count : 0;
+		}
+		Arena Space = Arena::GetScratchArena(Flags, Capacity);
+		Tiles = BitmapTiles::Create((u32)Width, (u32)Height, Space);
+	}
+
 	App::App()
 	{
-		DefaultArena = Arena::Create(DefaultArenaSize);
-		FrameArena = Arena::Create(1024*1024);
-		BackBuffer = { (u32)Width, (u32)Height, sizeof(u32) };
-		BackBuffer.Pixels = Allocate(Width * Height * sizeof(u32));
-		DefaultFont = Font::Load("../Jogo/Font16.fnt", DefaultArena);
+		// one worker per core besides this thread, started here rather than in Run so the assets an app loads in
+		// its constructor are already converted in parallel; Run shuts them down when it returns
+		Jobs::Init();
+
+		// both only commit what they use, and a big frame's worth of FrameArena is given back on the next Clear
+		// DefaultArena and the backbuffer are big and long lived, so they ask for huge pages
+		DefaultArena = Arena::CreateGrowable(Arena::DefaultReserveSize, 0, Arena::DefaultCommitChunk, 8, true);
+		FrameArena = Arena::CreateGrowable(Arena::DefaultReserveSize, 4 * 1024 * 1024);
+#if JOGO_PROFILE
+		MemoryReport::Track(DefaultArena, "DefaultArena");
+		MemoryReport::Track(FrameArena, "FrameArena");
+#endif
+		BackBuffer = { (u32)Width, (u32)Height, sizeof(u32), (u32)(Width * sizeof(u32)) };
+		BackBuffer.Pixels = AllocateHuge(Width * Height * sizeof(u32));
+		SizeTiles(BackBufferTiles, Width, Height);
+		BackBuffer.Tiles = &BackBufferTiles;
+		Assets = Pack::Open("Assets.jpak");
+		DefaultFont = Assets.LoadFont("../Jogo/Font16.fnt", DefaultArena);
 	}
 
 	void App::Resize(int width, int height)
@@ -29,14 +63,43 @@ namespace Jogo
 		if (width * height > Width * Height)
 		{
 			Free(BackBuffer.Pixels);
-			BackBuffer.Pixels = Allocate(width * height * 4);
+			BackBuffer.Pixels = AllocateHuge(width * height * 4);
 		}
 		BackBuffer.Width = width;
 		BackBuffer.Height = height;
+		BackBuffer.Pitch = (u32)(width * sizeof(u32));
+
+		SizeTiles(BackBufferTiles, width, height);
 		Width = width;
 		Height = height;
 	}
 
+	static void PrintPages(Arena& Summary, const char* Name, const void* Memory, size_t Size, const char* Asked)
+	{
+		Summary.Clear();
+		Print(str8::format(Summary, "{}: asked for {} pages, {} of {} KB on huge pages\n", Name, Asked, (u32)(GetHugePageBytes(Memory, Size) / 1024), (u32)(Size / 1024)));
+	}
+
+	static const char* PageKindName(u32 Pages)
+	{
+		return Pages == PAGES_NORMAL ? "normal" : "huge";
+	}
+
+	void PrintHugePages(App& App)
+	{
+		char Summary[256];
+		Arena SummaryArena = Arena::GetScratchArena((u8*)Summary, sizeof(Summary));
+		PrintPages(SummaryArena, "BackBuffer", App.BackBuffer.Pixels, App.BackBuffer.Width * App.BackBuffer.Height * sizeof(u32), "huge");
+
+		Arena* Arenas[] = { &App.DefaultArena, &App.FrameArena };
+		const char* Names[] = { "DefaultArena", "FrameArena" };
+		for (u32 i = 0; i < 2; i++)
+		{
+			Arena& Memory = *Arenas[i];
+			PrintPages(SummaryArena, Names[i], Memory.BaseAddress, Memory.ReserveSize ? Memory.Committed : Memory.Size, PageKindName(Memory.Pages));
+		}
+	}
+
 	void SetUIHandler(Input::InputHandler* UIHandler)
 	{
 		Jogo::UIHandler = UIHandler;
@@ -50,74 +113,292 @@ namespace Jogo
 		}
 	}
 
+	template<class T>
+	T Clamp(T input, T min, T max)
+	{
+		return input < min
+			? min
+			: input > max
+			? max
+			: input;
+	}
+
+	ShowSink* CurrentSink = nullptr;
+
+	void SetShowSink(ShowSink* Sink)
+	{
+		CurrentSink = Sink;
+	}
+
+	ShowSink* GetShowSink()
+	{
+		return CurrentSink;
+	}
+
+	void Show(u32* Buffer, int Width, int Height)
+	{
+		Bitmap::Rect All = { 0, 0, Width, Height };
+		Show(Buffer, Width, Height, &All, 1);
+	}
+
+	void Show(Bitmap& Buffer)
+	{
+		JOGO_ZONE("Show");
+		static const u32 MaxDirty = 64;
+
+		// the sinks and the window only take packed 32bpp rows, a padded bitmap would come out sheared
+		Assert(Buffer.PixelSize == sizeof(u32) && Buffer.Pitch == Buffer.Width * sizeof(u32));
+
+		Buffer.ResolveClears();
+		Bitmap::Rect Dirty[MaxDirty];
+		u32 DirtyCount = Buffer.GetDamage(Dirty, MaxDirty);
+		Buffer.ClearDamage();
+
+		u32 DirtyPixels = 0;
+		for (u32 i = 0; i < DirtyCount; i++)
+		{
+			DirtyPixels += (u32)(Dirty[i].w * Dirty[i].h);
+		}
+		JOGO_COUNTER("Show dirty pixels", DirtyPixels);
+		Show(Buffer.PixelBGRA, (int)Buffer.Width, (int)Buffer.Height, Dirty, DirtyCount);
+	}
+
+	bool RawFileSink::Open(const char* Filename)
+	{
+		FILE* fp = nullptr;
+		if (!fopen_s(&fp, Filename, "wb"))
+		{
+			File = fp;
+			return true;
+		}
+		return false;
+	}
+
+	void RawFileSink::Close()
+	{
+		if (File)
+		{
+			fclose((FILE*)File);
+			File = nullptr;
+		}
+		Free(Frame);
+		Frame = nullptr;
+		FrameWidth = FrameHeight = 0;
+	}
+
+	void RawFileSink::Present(const u32* Buffer, int Width, int Height)
+	{
+		// frames are written back to back as Width*Height BGRA pixels, no header
+		if (File)
+		{
+			fwrite(Buffer, sizeof(u32), (size_t)Width * Height, (FILE*)File);
+		}
+	}
+
+	void RawFileSink::PresentDamage(const u32* Buffer, int Width, int Height, const Bitmap::Rect* Dirty, u32 DirtyCount)
+	{
+		if (!File)
+			return;
+
+		// a new size starts the copy over from the whole frame
+		if (Width != FrameWidth || Height != FrameHeight)
+		{
+			Free(Frame);
+			Frame = (u32*)Allocate((size_t)Width * Height * sizeof(u32));
+			if (!Frame)
+			{
+				FrameWidth = FrameHeight = 0;
+				Present(Buffer, Width, Height);
+				return;
+			}
+			FrameWidth = Width;
+			FrameHeight = Height;
+			memcpy(Frame, Buffer, (size_t)Width * Height * sizeof(u32));
+		}
+		else
+		{
+			for (u32 i = 0; i < DirtyCount; i++)
+			{
+				const Bitmap::Rect& r = Dirty[i];
+				for (s32 y = r.y; y < r.y + r.h; y++)
+				{
+					memcpy(Frame + y * Width + r.x, Buffer + y * Width + r.x, r.w * sizeof(u32));
+				}
+			}
+		}
+		Present(Frame, Width, Height);
+	}
+
+	void ChecksumSink::Present(const u32* Buffer, int Width, int Height)
+	{
+		// FNV-1a over whole pixels rather than bytes, a quarter of the multiplies
+		u64 Hash = Checksum;
+		size_t Count = (size_t)Width * Height;
+		for (size_t i = 0; i < Count; i++)
+		{
+			Hash ^= Buffer[i];
+			Hash *= 0x100000001b3;
+		}
+		Checksum = Hash;
+		Frames++;
+	}
+
+	bool RunFrame(App& App, float FrameSeconds)
+	{
+		bool Done = false;
+		App.FrameArena.Clear();
+		Jobs::BeginFrame();
+		Profiler::BeginFrame();
+		Input::BeginFrame(UIHandler, &App);
+		Replay::RecordFrame(FrameSeconds);
+		{
+			JOGO_ZONE("Tick");
+			float DT;
+			u32 Steps = Pacing::GetSteps(FrameSeconds, DT);
+			for (u32 Step = 0; Step < Steps && !Done; Step++)
+			{
+				Done = App.Tick(DT);
+			}
+			for (u32 t = 0; t < NumTickHandlers; t++)
+			{
+				TickHandlers[t](Pacing::GetElapsedSeconds());
+			}
+		}
+		{
+			JOGO_ZONE("Draw");
+			App.Draw();
+		}
+		MemoryReport::EndFrame();
+		Profiler::EndFrame();
+		return Done;
+	}
+
+	volatile s32 RedrawRequested = 1;	// always draw the first frame
+	u64 RedrawTime = 0;					// Timer ticks, 0 when nothing is scheduled
+
+	void RequestRedraw()
+	{
+		RedrawRequested = 1;
+	}
+
+	void RequestRedrawIn(float Seconds)
+	{
+		u64 When = Timer::GetTicks() + (u64)(max(Seconds, 0.0f) * Timer::Frequency);
+		if (!RedrawTime || When < RedrawTime)
+		{
+			RedrawTime = When;
+		}
+	}
+
+	// for Run: true when a frame is due, otherwise the seconds until one will be, or -1 if only input can start one
+	bool IsRedrawDue(double& SecondsUntilDue)
+	{
+		SecondsUntilDue = -1;
+		if (RedrawRequested)
+			return true;
+
+		if (RedrawTime)
+		{
+			u64 Now = Timer::GetTicks();
+			if (Now >= RedrawTime)
+				return true;
+			SecondsUntilDue = (double)(RedrawTime - Now) / Timer::Frequency;
+		}
+		return false;
+	}
+
+	// for Run: the frame about to start satisfies every request made so far
+	void BeginRedraw()
+	{
+		RedrawRequested = 0;
+		if (RedrawTime && Timer::GetTicks() >= RedrawTime)
+		{
+			RedrawTime = 0;
+		}
+	}
+
+	u32 Random::GetNext()
+	{
+		State ^= State << 13;
+		State ^= State >> 17;
+		State ^= State << 5;
+
+		return State;
+	}
+};
+
+#ifdef _WIN32
+namespace Jogo
+{
+	HDC hdc;
+	HWND hwnd;
+
+	static Input::Keys GetMouseButton(UINT uMsg)
+	{
+		switch (uMsg)
+		{
+		case WM_RBUTTONDOWN:
+		case WM_RBUTTONUP:
+		case WM_RBUTTONDBLCLK:
+			return Input::BUTTON_RIGHT;
+		case WM_MBUTTONDOWN:
+		case WM_MBUTTONUP:
+		case WM_MBUTTONDBLCLK:
+			return Input::BUTTON_MIDDLE;
+		default:
+			return Input::BUTTON_LEFT;
+		}
+	}
+
 	LRESULT CALLBACK JogoWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 	{
 		// get current input handler
 		App* app = (App*)GetWindowLongPtr(hwnd, GWLP_USERDATA);
-		Input::Keys key = (Input::Keys)wParam;
+
+		// input is queued for the top of the next frame, coordinates are signed while the mouse is captured
+		s32 x = (s16)LOWORD(lParam);
+		s32 y = (s16)HIWORD(lParam);
 		switch (uMsg)
 		{
 		case WM_KEYDOWN:
-			if (!UIHandler || (UIHandler && !UIHandler->KeyDown(key)))
-			{
-				if (app)
-					app->KeyDown(key);
-			}
+			Input::PostEvent(Input::EVENT_KEY_DOWN, (s32)wParam);
 			break;
 
 		case WM_KEYUP:
-			if (app)
-				app->KeyUp(key);
+			Input::PostEvent(Input::EVENT_KEY_UP, (s32)wParam);
 			break;
 
 		case WM_CHAR:
-			if (!UIHandler || (UIHandler && !UIHandler->Char((char)wParam)))
-			{
-				if (app)
-					app->Char((char)wParam);
-			}
+			Input::PostEvent(Input::EVENT_CHAR, (s32)wParam);
 			break;
 
 		case WM_LBUTTONDOWN:
 		case WM_RBUTTONDOWN:
 		case WM_MBUTTONDOWN:
 			SetCapture(hwnd);
-			if (!UIHandler || (UIHandler && !UIHandler->MouseDown((s32)LOWORD(lParam), (s32)HIWORD(lParam), key)))
-			{
-				if (app)
-					app->MouseDown((s32)LOWORD(lParam), (s32)HIWORD(lParam), key);
-			}
+			Input::PostEvent(Input::EVENT_MOUSE_DOWN, GetMouseButton(uMsg), x, y);
 			break;
 
 		case WM_LBUTTONUP:
 		case WM_RBUTTONUP:
 		case WM_MBUTTONUP:
 			ReleaseCapture();
-			if (!UIHandler || (UIHandler && !UIHandler->MouseUp((s32)LOWORD(lParam), (s32)HIWORD(lParam), key)))
-			{
-				if (app)
-					app->MouseUp((s32)LOWORD(lParam), (s32)HIWORD(lParam), key);
-			}
+			Input::PostEvent(Input::EVENT_MOUSE_UP, GetMouseButton(uMsg), x, y);
 			break;
 
 		case WM_LBUTTONDBLCLK:
 		case WM_RBUTTONDBLCLK:
 		case WM_MBUTTONDBLCLK:
-			if (!UIHandler || (UIHandler && !UIHandler->MouseDoubleClick((s32)LOWORD(lParam), (s32)HIWORD(lParam), key)))
-			{
-				if (app)
-					app->MouseDoubleClick((s32)LOWORD(lParam), (s32)HIWORD(lParam), key);
-			}
+			SetCapture(hwnd);
+			Input::PostEvent(Input::EVENT_MOUSE_DOUBLE_CLICK, GetMouseButton(uMsg), x, y);
 			break;
 
 		case WM_MOUSEMOVE:
-			if (app)
-				app->MouseMove((s32)LOWORD(lParam), (s32)HIWORD(lParam));
+			Input::PostEvent(Input::EVENT_MOUSE_MOVE, 0, x, y);
 			break;
 
 		case WM_MOUSEWHEEL:
-			if (app)
-				app->MouseWheel(GET_WHEEL_DELTA_WPARAM(wParam));
+			Input::PostEvent(Input::EVENT_MOUSE_WHEEL, GET_WHEEL_DELTA_WPARAM(wParam));
 			break;
 
 		case WM_DESTROY:
@@ -131,6 +412,7 @@ namespace Jogo
 				if (app)
 					app->Resize(width, height);
 				InvalidateRect(hwnd, NULL, FALSE);
+				RequestRedraw();
 			}
 			break;
 
@@ -139,14 +421,22 @@ namespace Jogo
 				PAINTSTRUCT ps;
 				HDC hdc = BeginPaint(hwnd, &ps);
 				if (app)
+				{
+					// whatever was uncovered needs presenting, not just what this Draw changes
+					app->BackBuffer.DamageAll();
 					app->Draw();
+				}
 				EndPaint(hwnd, &ps);
 			}
 			return 0;
 
 		case WM_ACTIVATE:
 			if (wParam == WA_INACTIVE)
+			{
+				// we won't see the key ups for anything held while switching away
 				Pause = true;
+				Input::PostEvent(Input::EVENT_FOCUS_LOST);
+			}
 			else
 				Pause = false;
 			return 0;
@@ -154,22 +444,18 @@ namespace Jogo
 		return DefWindowProc(hwnd, uMsg, wParam, lParam);
 	}
 
-	template<class T>
-	T Clamp(T input, T min, T max)
+	static u64 QueryFrequency()
 	{
-		return input < min
-			? min
-			: input > max
-			? max
-			: input;
+		u64 Result;
+		QueryPerformanceFrequency((LARGE_INTEGER*)&Result);
+		return Result;
 	}
 
+	// set before main, so GetTicks can be converted without a Timer ever being constructed
+	u64 Timer::Frequency = QueryFrequency();
+
 	Timer::Timer()
 	{
-		if (!Frequency)
-		{
-			QueryPerformanceFrequency((LARGE_INTEGER*)&Frequency);
-		}
 		QueryPerformanceCounter((LARGE_INTEGER*)&Last);
 	}
 
@@ -179,6 +465,13 @@ namespace Jogo
 		return Last;
 	}
 
+	u64 Timer::GetTicks()
+	{
+		u64 Now;
+		QueryPerformanceCounter((LARGE_INTEGER*)&Now);
+		return Now;
+	}
+
 	double Timer::GetSecondsSinceLast()
 	{
 		u64 Now;
@@ -188,19 +481,56 @@ namespace Jogo
 		return result;
 	}
 
-	u64 Timer::Frequency = 0;
-
-	u32 Random::GetNext()
+	// returns true once the window has been closed
+	static bool PumpMessages()
 	{
-		State ^= State << 13;
-		State ^= State >> 17;
-		State ^= State << 5;
+		bool Quit = false;
+		MSG msg = {};
+		while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE) > 0)
+		{
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
 
-		return State;
+			if (msg.message == WM_QUIT)
+			{
+				Quit = true;
+			}
+		}
+		return Quit;
+	}
+
+	// JOGO_REPLAY: no window to feed input and nothing to wait for, every recorded frame runs back to back
+	static void RunReplay(App& App)
+	{
+		Timer ReplayTimer;
+		u32 FrameCount = 0;
+		bool Done = false;
+		float FrameSeconds;
+		Pacing::BeginRun(0);
+		while (!Done && Replay::NextFrame(FrameSeconds))
+		{
+			Done = RunFrame(App, FrameSeconds);
+			FrameCount++;
+		}
+		double Seconds = ReplayTimer.GetSecondsSinceLast();
+		Replay::EndPlayback();
+		Profiler::EndCapture();
+		Jobs::Shutdown();
+
+		char Summary[256];
+		Arena SummaryArena = Arena::GetScratchArena((u8*)Summary, sizeof(Summary));
+		DebugOut(str8::format(SummaryArena, "{}: replayed {} frames in {:0.3} s\n", App.GetName(), FrameCount, (float)Seconds));
 	}
 
 	void Run(App& App, int TargetFPS)
 	{
+		const char* ReplayName = getenv("JOGO_REPLAY");
+		if (ReplayName && Replay::BeginPlayback(ReplayName))
+		{
+			RunReplay(App);
+			return;
+		}
+
 		// register window class
 		WNDCLASS wc = {};
 		wc.style = WS_OVERLAPPED | CS_DBLCLKS;
@@ -227,94 +557,283 @@ namespace Jogo
 				ShowWindow(hwnd, SW_SHOWNORMAL);
 				UpdateWindow(hwnd);
 
-				// default 60Hz
-				float TargetFrameTimeMS = 16.6666f;
 				TargetFPS = Clamp(TargetFPS, 10, 1000);
-				TargetFrameTimeMS = 1000.0f / TargetFPS;
 
+				// Pacing only sleeps part of the frame, but a 15ms scheduler tick would still eat all of it
 				UINT DesiredSchedulerMS = 1;
 				bool SleepIsGranular = (timeBeginPeriod(DesiredSchedulerMS) == TIMERR_NOERROR);
 
-				bool Done = false;
-				Timer timer;
-				timer.Start();
-				while (!Done)
+				// JOGO_CAPTURE=trace.json [JOGO_CAPTURE_FRAMES=n] records a profiler capture from the first frame
+				const char* CaptureName = getenv("JOGO_CAPTURE");
+				if (CaptureName)
 				{
-					double Seconds = timer.GetSecondsSinceLast();
-					float MSeconds = (float)(Seconds * 1000.0);
-					int MSecondsLeft = (int)(TargetFrameTimeMS - MSeconds);
+					const char* CaptureFrames = getenv("JOGO_CAPTURE_FRAMES");
+					Profiler::BeginCapture(CaptureName, CaptureFrames ? (u32)atoi(CaptureFrames) : 0);
+				}
 
-					Timer sleeptimer;
-					sleeptimer.Start();
-					if (MSecondsLeft > 0)
-					{
-						Sleep(MSecondsLeft);
-					}
-					double SleepTime = sleeptimer.GetSecondsSinceLast();
-					float DT = (float)(Seconds + SleepTime);	// MSecondsLeft / 1000.0f + (float)Seconds;
+				// JOGO_RECORD=file records every frame's time and input for JOGO_REPLAY
+				const char* RecordName = getenv("JOGO_RECORD");
+				if (RecordName)
+				{
+					Replay::BeginRecording(RecordName);
+				}
 
-					if (!Pause)
+				bool Done = false;
+				Pacing::BeginRun(TargetFPS);
+				while (!Done)
+				{
+					// on demand apps, and every app while its window is in the background, sleep until there is something to do
+					double SecondsUntilDue = -1;
+					if (Pause || (App.RedrawOnDemand && !IsRedrawDue(SecondsUntilDue)))
 					{
-						timer.Start();
-
-						DT = Clamp(DT, 0.001f, 0.1f);
-						Done = App.Tick(DT);
-						for (u32 t = 0; t < NumTickHandlers; t++)
+						DWORD Timeout = (Pause || SecondsUntilDue < 0) ? INFINITE : (DWORD)(SecondsUntilDue * 1000.0) + 1;
+						MsgWaitForMultipleObjectsEx(0, nullptr, Timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+						bool WasPaused = Pause;
+						Done = PumpMessages();
+						if (WasPaused)
 						{
-							TickHandlers[t](DT);
+							Pacing::Skip();
 						}
-						App.Draw();
-					}
-					// message pump
-					MSG msg = {};
-					while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE) > 0)
-					{
-						TranslateMessage(&msg);
-						DispatchMessage(&msg);
-
-						if (msg.message == WM_QUIT)
+						else
 						{
-							Done = true;
+							Pacing::Resume();
 						}
+						continue;
+					}
+
+					float FrameSeconds = Pacing::WaitForFrame();
+					BeginRedraw();
+					Done = RunFrame(App, FrameSeconds);
+					if (PumpMessages())
+					{
+						Done = true;
 					}
 				}
+				Replay::EndRecording();
+				Profiler::EndCapture();
+				Jobs::Shutdown();
+				if (SleepIsGranular)
+				{
+					timeEndPeriod(DesiredSchedulerMS);
+				}
 			}
 		}
 	}
 
-	void* Allocate(size_t Size)
+	void* AllocatePages(size_t Size)
 	{
 		return VirtualAlloc(nullptr, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
 	}
 
-	void Free(void* Memory)
+	void FreePages(void* Memory)
 	{
 		VirtualFree(Memory, 0, MEM_RELEASE);
 	}
 
-	void Show(u32* Buffer, int Width, int Height)
+	void* Reserve(size_t Size)
+	{
+		return VirtualAlloc(nullptr, Size, MEM_RESERVE, PAGE_NOACCESS);
+	}
+
+	bool Commit(void* Memory, size_t Size)
 	{
+		return VirtualAlloc(Memory, Size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	}
+
+	void Decommit(void* Memory, size_t Size)
+	{
+		VirtualFree(Memory, Size, MEM_DECOMMIT);
+	}
+
+	void Release(void* Memory, size_t Size)
+	{
+		VirtualFree(Memory, 0, MEM_RELEASE);
+	}
+
+	bool MapFile(const char* Filename, MappedFile& File)
+	{
+		File = {};
+		HANDLE FileHandle = CreateFileA(Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (FileHandle == INVALID_HANDLE_VALUE)
+			return false;
+
+		// the view keeps the mapping and the file open, neither handle is needed past MapViewOfFile
+		LARGE_INTEGER FileSize;
+		if (GetFileSizeEx(FileHandle, &FileSize) && FileSize.QuadPart > 0)
+		{
+			HANDLE Mapping = CreateFileMappingA(FileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (Mapping)
+			{
+				File.Data = (u8*)MapViewOfFile(Mapping, FILE_MAP_COPY, 0, 0, 0);
+				File.Size = File.Data ? (size_t)FileSize.QuadPart : 0;
+				CloseHandle(Mapping);
+			}
+		}
+		CloseHandle(FileHandle);
+		return File.Data != nullptr;
+	}
+
+	void UnmapFile(MappedFile& File)
+	{
+		if (File.Data)
+		{
+			UnmapViewOfFile(File.Data);
+		}
+		File = {};
+	}
+
+	// large pages need the "Lock pages in memory" right, which has to be granted to the user and then switched on
+	static size_t GetLargePageSize()
+	{
+		HANDLE Token;
+		TOKEN_PRIVILEGES Privileges = { 1 };
+		if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &Token))
+			return 0;
+
+		Privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool Enabled = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &Privileges.Privileges[0].Luid) &&
+			AdjustTokenPrivileges(Token, FALSE, &Privileges, 0, nullptr, nullptr) && GetLastError() == ERROR_SUCCESS;
+		CloseHandle(Token);
+		return Enabled ? GetLargePageMinimum() : 0;
+	}
+
+	void* AllocateHuge(size_t Size, u32* Pages)
+	{
+		static size_t LargePageSize = GetLargePageSize();
+		if (LargePageSize)
+		{
+			void* Memory = VirtualAlloc(nullptr, (Size + LargePageSize - 1) & ~(LargePageSize - 1), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (Memory)
+			{
+				if (Pages)
+				{
+					*Pages = PAGES_HUGE;
+				}
+				return Memory;
+			}
+		}
+		if (Pages)
+		{
+			*Pages = PAGES_NORMAL;
+		}
+		return AllocatePages(Size);
+	}
+
+	void* ReserveHuge(size_t Size, u32* Pages)
+	{
+		if (Pages)
+		{
+			*Pages = PAGES_NORMAL;
+		}
+		return Reserve(Size);
+	}
+
+	// large pages are all or nothing, so the first page says for the whole range
+	size_t GetHugePageBytes(const void* Memory, size_t Size)
+	{
+		PSAPI_WORKING_SET_EX_INFORMATION Info = {};
+		Info.VirtualAddress = (void*)Memory;
+		if (QueryWorkingSetEx(GetCurrentProcess(), &Info, sizeof(Info)) && Info.VirtualAttributes.Valid && Info.VirtualAttributes.LargePage)
+			return Size;
+		return 0;
+	}
+
+	void SleepSeconds(double Seconds)
+	{
+		Sleep((DWORD)(Seconds * 1000.0));
+	}
+
+	static DWORD WINAPI ThreadEntry(LPVOID Parameter)
+	{
+		Thread* thread = (Thread*)Parameter;
+		thread->Function(thread->Data);
+		// whatever blocks the thread freed go back to the heap rather than leaving with it
+		Heap::FlushThreadCache();
+		return 0;
+	}
+
+	bool Thread::Start(ThreadFunction* InFunction, void* InData)
+	{
+		Function = InFunction;
+		Data = InData;
+		Handle = ::CreateThread(nullptr, 0, ThreadEntry, this, 0, nullptr);
+		return Handle != nullptr;
+	}
+
+	void Thread::Join()
+	{
+		if (Handle)
+		{
+			WaitForSingleObject((HANDLE)Handle, INFINITE);
+			CloseHandle((HANDLE)Handle);
+			Handle = nullptr;
+		}
+	}
+
+	bool Semaphore::Create(u32 InitialCount)
+	{
+		Handle = CreateSemaphoreA(nullptr, InitialCount, 0x7fffffff, nullptr);
+		return Handle != nullptr;
+	}
+
+	void Semaphore::Signal(u32 Count)
+	{
+		ReleaseSemaphore((HANDLE)Handle, Count, nullptr);
+	}
+
+	void Semaphore::Wait()
+	{
+		WaitForSingleObject((HANDLE)Handle, INFINITE);
+	}
+
+	void Semaphore::Release()
+	{
+		if (Handle)
+		{
+			CloseHandle((HANDLE)Handle);
+			Handle = nullptr;
+		}
+	}
+
+	u32 GetProcessorCount()
+	{
+		SYSTEM_INFO Info;
+		GetSystemInfo(&Info);
+		return Info.dwNumberOfProcessors;
+	}
+
+	void Show(u32* Buffer, int Width, int Height, const Bitmap::Rect* Dirty, u32 DirtyCount)
+	{
+		if (CurrentSink)
+		{
+			CurrentSink->PresentDamage(Buffer, Width, Height, Dirty, DirtyCount);
+		}
+
 		BITMAPINFO Info = {};
 		Info.bmiHeader.biSize = sizeof(Info.bmiHeader);
 		Info.bmiHeader.biWidth = Width;
-		Info.bmiHeader.biHeight = -Height;
 		Info.bmiHeader.biPlanes = 1;
 		Info.bmiHeader.biBitCount = 32;
 		Info.bmiHeader.biCompression = BI_RGB;
 
-
-		StretchDIBits(hdc,
-			0, 0, Width, Height,
-//			128, 768, Width/8, Height/8,
-			0, 0, Width, Height,
-			Buffer,
-			&Info,
-			DIB_RGB_COLORS, SRCCOPY);
+		// each rect goes as a top-down DIB of just its rows, so the source y is never the bottom-up kind
+		for (u32 i = 0; i < DirtyCount; i++)
+		{
+			const Bitmap::Rect& r = Dirty[i];
+			Info.bmiHeader.biHeight = -r.h;
+			StretchDIBits(hdc,
+				r.x, r.y, r.w, r.h,
+				r.x, 0, r.w, r.h,
+				Buffer + r.y * Width,
+				&Info,
+				DIB_RGB_COLORS, SRCCOPY);
+		}
 	}
 
 	void DebugOut(const str8& message)
 	{
-		char* localstring = (char*)_alloca(message.len+1);
+		TempMemory Scratch = GetScratch();
+		char* localstring = (char*)Scratch.Allocate(message.len+1);
 		str8::copystring(message.chars, localstring, (u32)message.len, (u32)message.len);
 		localstring[message.len] = 0;
 
@@ -332,19 +851,4 @@ namespace Jogo
 	}
 };
 
-namespace Input
-{
-	bool IsKeyPressed(int key)
-	{
-		return (GetAsyncKeyState(key) & 0x8000) != 0;
-	}
-
-	void GetMousePos(int& x, int& y)
-	{
-		POINT point;
-		GetCursorPos(&point);
-		ScreenToClient(Jogo::hwnd, &point);
-		x = point.x;
-		y = point.y;
-	}
-};
\ No newline at end of file
+#endif
@@ -1,10 +1,22 @@
 #pragma once
 #include "int_types.h"
 #include "Arena.h"
+#include "Pool.h"
+#include "Heap.h"
+#include "MemoryReport.h"
+#include "Array.h"
+#include "HashMap.h"
+#include "Intern.h"
+#include "Pixels.h"
 #include "Bitmap.h"
 #include "Font.h"
+#include "Pack.h"
 #include "JMath.h"
 #include "Input.h"
+#include "Jobs.h"
+#include "Profiler.h"
+#include "Pacing.h"
+#include "Replay.h"
 
 namespace Jogo
 {
@@ -14,10 +26,12 @@ namespace Jogo
 	public:
 		int Width = 1024;
 		int Height = 1024;
-		int DefaultArenaSize = 64 * 1024 * 1024;
+		bool RedrawOnDemand = false;	// see RequestRedraw
 		Arena DefaultArena;
 		Arena FrameArena;
 		Bitmap BackBuffer;
+		BitmapTiles BackBufferTiles = {};	// so the apps' Erase every frame is lazy
+		Pack Assets;					// Assets.jpak in the working directory if there is one, load through it
 		Font DefaultFont;
 
 		App();
@@ -33,18 +47,134 @@ namespace Jogo
 	// event loop
 	void Run(Jogo::App& App, int TargetFPS);
 
+	// one pass of Run's loop: drains input, runs the Tick steps FrameSeconds calls for, then Draw
+	// returns true once the app is done
+	bool RunFrame(Jogo::App& App, float FrameSeconds);
+
+	// an App with RedrawOnDemand set only gets Tick and Draw after input, a RequestRedraw, or a RequestRedrawIn
+	// coming due, and Run blocks in between. Call these from the main thread, typically from Tick or Draw
+	void RequestRedraw();
+	void RequestRedrawIn(float Seconds);
+
 	void SetUIHandler(Input::InputHandler* UIHandler);
-	typedef void TickHandler(float DeltaTime);
+	// tick handlers run once a frame after App::Tick, with Pacing::GetElapsedSeconds rather than a clamped DT
+	typedef void TickHandler(float ElapsedSeconds);
 	void SetTickHandler(TickHandler);
 
 	// memory
+	// zeroed, from the size-class heap up to Heap::MaxSmallSize and straight from the OS past that, see Heap.h
+	// 16 byte aligned, except that 17 to 24 bytes comes from the 24 byte class and is only 8 byte aligned
 	void* Allocate(size_t Size);
 	void Free(void* Memory);
 
+	// always straight from the OS, whole pages
+	void* AllocatePages(size_t Size);
+	void FreePages(void* Memory);
+
+	// address space that costs nothing until ranges inside it are committed, keep everything 64KB aligned
+	void* Reserve(size_t Size);
+	bool Commit(void* Memory, size_t Size);
+	void Decommit(void* Memory, size_t Size);
+	void Release(void* Memory, size_t Size);
+
+	// 2MB pages where the OS will hand them out, so big buffers that are touched all over every frame don't
+	// thrash the TLB. Both quietly fall back to normal pages and say what they got in Pages
+	enum PageKind : u32
+	{
+		PAGES_NORMAL,
+		PAGES_HUGE,				// hugetlbfs or Windows large pages, all of it is on 2MB pages
+		PAGES_TRANSPARENT,		// Linux transparent huge pages were asked for, the kernel decides as pages fault in
+	};
+
+	// Free releases this too
+	void* AllocateHuge(size_t Size, u32* Pages = nullptr);
+
+	// Windows can't commit large pages a bit at a time, so this is a plain Reserve there
+	void* ReserveHuge(size_t Size, u32* Pages = nullptr);
+
+	// how much of [Memory, Memory + Size) is actually on huge pages right now
+	size_t GetHugePageBytes(const void* Memory, size_t Size);
+
+	// threads
+	typedef void ThreadFunction(void* Data);
+
+	struct Thread
+	{
+		ThreadFunction* Function;
+		void* Data;
+		void* Handle;
+
+		// the new thread reads Function and Data through this, so it must stay put until Join
+		bool Start(ThreadFunction* InFunction, void* InData);
+		void Join();
+	};
+
+	struct Semaphore
+	{
+		void* Handle;
+
+		bool Create(u32 InitialCount = 0);
+		void Signal(u32 Count = 1);
+		void Wait();
+		void Release();
+	};
+
+	u32 GetProcessorCount();
+
+	// at least Seconds, the OS decides how much more
+	void SleepSeconds(double Seconds);
+
+	// the backbuffer's and App arenas' huge page coverage, one line each
+	void PrintHugePages(App& App);
+
 	// graphics
 	void Show(u32* Buffer, int Width, int Height);
+	// only the Dirty rects of Buffer have changed since the last Show, the rest of the window is left as it was
+	void Show(u32* Buffer, int Width, int Height, const Bitmap::Rect* Dirty, u32 DirtyCount);
+	// resolves Buffer's pending clears and presents only its damage
+	// Buffer has to be 32bpp with packed rows, Pitch == Width * 4, like the BackBuffer; a bitmap made with
+	// Bitmap::Create(..., true) or pointing into a Pack can have padded rows, and asserts here
+	void Show(Bitmap& Buffer);
 	void DrawString(int x, int y, const str8& string);
 
+	// Show also hands each frame to the current sink, the headless backend has no window so this is its only output
+	struct ShowSink
+	{
+		virtual void Present(const u32* Buffer, int Width, int Height) {}
+
+		// only the Dirty rects changed since the last frame, a sink keeping its own copy of the frame need only copy those
+		virtual void PresentDamage(const u32* Buffer, int Width, int Height, const Bitmap::Rect* Dirty, u32 DirtyCount)
+		{
+			Present(Buffer, Width, Height);
+		}
+	};
+
+	struct RawFileSink : public ShowSink
+	{
+		void* File = nullptr;
+
+		// the file wants whole frames, so damaged frames are patched into this copy and it's written instead
+		u32* Frame = nullptr;
+		int FrameWidth = 0;
+		int FrameHeight = 0;
+
+		bool Open(const char* Filename);
+		void Close();
+		void Present(const u32* Buffer, int Width, int Height) override;
+		void PresentDamage(const u32* Buffer, int Width, int Height, const Bitmap::Rect* Dirty, u32 DirtyCount) override;
+	};
+
+	struct ChecksumSink : public ShowSink
+	{
+		u64 Checksum = 0xcbf29ce484222325;	// FNV-1a offset basis
+		u32 Frames = 0;
+
+		void Present(const u32* Buffer, int Width, int Height) override;
+	};
+
+	void SetShowSink(ShowSink* Sink);
+	ShowSink* GetShowSink();
+
 	// debug
 	void DebugOut(const str8& message);
 	void Print(const str8& message);
@@ -62,6 +192,9 @@ namespace Jogo
 		Timer();
 		u64 Start();
 		double GetSecondsSinceLast();
+
+		// the current time in Frequency units, Frequency is set before main runs
+		static u64 GetTicks();
 	};
 
 	struct Random
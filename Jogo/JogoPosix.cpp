@@ -0,0 +1,459 @@
+#ifndef _WIN32
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "Jogo.h"
+
+// headless backend: there is no window, Show goes to a ShowSink and the frame loop runs unattended
+// configured from the environment so the apps' main() stays the same on every platform
+//	JOGO_FRAMES=n		stop after n frames (default: run until Tick returns true)
+//	JOGO_SINK=name		null (default), checksum, or a filename to receive raw BGRA frames
+//	JOGO_THROTTLE=1		pace to the app's TargetFPS and print frame time stats, instead of running flat out with a fixed DT
+//				also lets a RedrawOnDemand app go idle, and the run ends once nothing is left to wake it
+//	JOGO_RECORD=file	record every frame's time and input
+//	JOGO_REPLAY=file	play a recording back flat out instead, ending with it
+//	JOGO_PAGES=1		print how much of the backbuffer and App arenas ended up on huge pages
+
+namespace Jogo
+{
+	extern ShowSink* CurrentSink;
+	bool IsRedrawDue(double& SecondsUntilDue);
+	void BeginRedraw();
+
+	static u64 GetNanoseconds()
+	{
+		timespec Now;
+		clock_gettime(CLOCK_MONOTONIC, &Now);
+		return (u64)Now.tv_sec * 1000000000ull + Now.tv_nsec;
+	}
+
+	u64 Timer::Frequency = 1000000000ull;
+
+	Timer::Timer()
+	{
+		Last = GetNanoseconds();
+	}
+
+	u64 Timer::Start()
+	{
+		Last = GetNanoseconds();
+		return Last;
+	}
+
+	u64 Timer::GetTicks()
+	{
+		return GetNanoseconds();
+	}
+
+	double Timer::GetSecondsSinceLast()
+	{
+		u64 Now = GetNanoseconds();
+		double result = ((double)Now - Last) / Frequency;
+		Last = Now;
+		return result;
+	}
+
+	static str8 GetEnvironment(const char* Name)
+	{
+		const char* Value = getenv(Name);
+		if (!Value)
+			return str8("", (size_t)0);
+		return str8(Value, str8::cstringlength(Value));
+	}
+
+	void Run(App& App, int TargetFPS)
+	{
+		TargetFPS = clamp(TargetFPS, 10, 1000);
+		float TargetFrameTime = 1.0f / TargetFPS;
+
+		str8 Frames = GetEnvironment("JOGO_FRAMES");
+		u32 MaxFrames = Frames.len ? (u32)Frames.atoi() : 0;
+		bool Throttle = GetEnvironment("JOGO_THROTTLE").atoi() != 0;
+
+		// an app that installed its own sink keeps it
+		ShowSink NullSink;
+		ChecksumSink Checksum;
+		RawFileSink RawFile;
+		ShowSink* AppSink = CurrentSink;
+		if (!AppSink)
+		{
+			str8 SinkName = GetEnvironment("JOGO_SINK");
+			if (SinkName == str8("checksum"))
+			{
+				CurrentSink = &Checksum;
+			}
+			else if (SinkName.len && SinkName != str8("null"))
+			{
+				// an unattended run that can't record has nothing to give back, so it stops rather than carrying on
+				if (!RawFile.Open(SinkName.chars))
+				{
+					fprintf(stderr, "JOGO_SINK: can't open %s for writing\n", SinkName.chars);
+					exit(1);
+				}
+				CurrentSink = &RawFile;
+			}
+			else
+			{
+				CurrentSink = &NullSink;
+			}
+		}
+
+		str8 CaptureName = GetEnvironment("JOGO_CAPTURE");
+		if (CaptureName.len)
+		{
+			Profiler::BeginCapture(CaptureName.chars, (u32)GetEnvironment("JOGO_CAPTURE_FRAMES").atoi());
+		}
+
+		str8 ReplayName = GetEnvironment("JOGO_REPLAY");
+		bool Playing = ReplayName.len && Replay::BeginPlayback(ReplayName.chars);
+		if (Playing)
+		{
+			Throttle = false;
+		}
+		else
+		{
+			str8 RecordName = GetEnvironment("JOGO_RECORD");
+			if (RecordName.len)
+			{
+				Replay::BeginRecording(RecordName.chars);
+			}
+		}
+
+		Timer RunTimer;
+		u32 FrameCount = 0;
+		bool Done = false;
+		Pacing::BeginRun(Throttle ? TargetFPS : 0);
+		while (!Done && (!MaxFrames || FrameCount < MaxFrames))
+		{
+			float FrameSeconds;
+			if (Playing)
+			{
+				if (!Replay::NextFrame(FrameSeconds))
+					break;
+
+				Done = RunFrame(App, FrameSeconds);
+				FrameCount++;
+				continue;
+			}
+
+			// with no input to wait for, only throttled runs go idle; unthrottled ones draw every frame to stay deterministic
+			double SecondsUntilDue;
+			if (Throttle && App.RedrawOnDemand && !IsRedrawDue(SecondsUntilDue))
+			{
+				if (SecondsUntilDue < 0)
+					break;
+
+				SleepSeconds(SecondsUntilDue);
+				Pacing::Resume();
+				continue;
+			}
+
+			// unthrottled runs pretend every frame took exactly the target time so every run simulates the same frames
+			FrameSeconds = Pacing::WaitForFrame();
+			BeginRedraw();
+			if (!Throttle)
+			{
+				FrameSeconds = TargetFrameTime;
+			}
+			Done = RunFrame(App, FrameSeconds);
+			FrameCount++;
+		}
+		double Seconds = RunTimer.GetSecondsSinceLast();
+		Replay::EndRecording();
+		Replay::EndPlayback();
+		Profiler::EndCapture();
+		Jobs::Shutdown();
+
+		char Summary[256];
+		Arena SummaryArena = Arena::GetScratchArena((u8*)Summary, sizeof(Summary));
+		Print(str8::format(SummaryArena, "{}: {} frames in {:0.3} s, {:0.1} fps\n",
+			App.GetName(), FrameCount, (float)Seconds, (float)(FrameCount / (Seconds > 0 ? Seconds : 1))));
+		if (CurrentSink == &Checksum)
+		{
+			SummaryArena.Clear();
+			Print(str8::format(SummaryArena, "checksum: {:08X}{:08X}\n", (u32)(Checksum.Checksum >> 32), (u32)Checksum.Checksum));
+		}
+		if (Throttle)
+		{
+			Pacing::FrameStats Stats = Pacing::GetFrameStats();
+			SummaryArena.Clear();
+			Print(str8::format(SummaryArena, "frame ms: p50 {:0.3} p99 {:0.3} max {:0.3}, {} missed\n", Stats.P50, Stats.P99, Stats.Max, Stats.Missed));
+		}
+		if (GetEnvironment("JOGO_PAGES").len)
+		{
+			PrintHugePages(App);
+		}
+
+		RawFile.Close();
+		CurrentSink = AppSink;
+	}
+
+	// mmap has no VirtualFree-style size lookup, so the mapping length lives in a header page in front of the block
+	const size_t AllocationHeader = 4096;
+
+	void* AllocatePages(size_t Size)
+	{
+		size_t MappedSize = Size + AllocationHeader;
+		u8* Base = (u8*)mmap(nullptr, MappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (Base == MAP_FAILED)
+			return nullptr;
+
+		*(size_t*)Base = MappedSize;
+		return Base + AllocationHeader;
+	}
+
+	void FreePages(void* Memory)
+	{
+		if (Memory)
+		{
+			u8* Base = (u8*)Memory - AllocationHeader;
+			munmap(Base, *(size_t*)Base);
+		}
+	}
+
+	void* Reserve(size_t Size)
+	{
+		void* Base = mmap(nullptr, Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return Base == MAP_FAILED ? nullptr : Base;
+	}
+
+	bool Commit(void* Memory, size_t Size)
+	{
+		return mprotect(Memory, Size, PROT_READ | PROT_WRITE) == 0;
+	}
+
+	// hand the pages back now, they come back zeroed if they are committed again
+	void Decommit(void* Memory, size_t Size)
+	{
+		madvise(Memory, Size, MADV_DONTNEED);
+		mprotect(Memory, Size, PROT_NONE);
+	}
+
+	void Release(void* Memory, size_t Size)
+	{
+		if (Memory)
+		{
+			munmap(Memory, Size);
+		}
+	}
+
+	bool MapFile(const char* Filename, MappedFile& File)
+	{
+		File = {};
+		int Descriptor = open(Filename, O_RDONLY);
+		if (Descriptor < 0)
+			return false;
+
+		// the mapping keeps the file open, the descriptor isn't needed past mmap
+		struct stat Info;
+		if (!fstat(Descriptor, &Info) && Info.st_size > 0)
+		{
+			void* Data = mmap(nullptr, (size_t)Info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, Descriptor, 0);
+			if (Data != MAP_FAILED)
+			{
+				File.Data = (u8*)Data;
+				File.Size = (size_t)Info.st_size;
+			}
+		}
+		close(Descriptor);
+		return File.Data != nullptr;
+	}
+
+	void UnmapFile(MappedFile& File)
+	{
+		if (File.Data)
+		{
+			munmap(File.Data, File.Size);
+		}
+		File = {};
+	}
+
+	static const size_t HugePageSize = 2 * 1024 * 1024;
+
+	// maps a huge page extra and trims it off again so the range starts on a 2MB boundary
+	static u8* MapHugeAligned(size_t Size, int Protection, int Flags)
+	{
+		u8* Mapped = (u8*)mmap(nullptr, Size + HugePageSize, Protection, MAP_PRIVATE | MAP_ANONYMOUS | Flags, -1, 0);
+		if (Mapped == MAP_FAILED)
+			return nullptr;
+
+		u8* Aligned = (u8*)(((size_t)Mapped + HugePageSize - 1) & ~(HugePageSize - 1));
+		if (Aligned > Mapped)
+		{
+			munmap(Mapped, Aligned - Mapped);
+		}
+		size_t Tail = (size_t)((Mapped + Size + HugePageSize) - (Aligned + Size));
+		if (Tail)
+		{
+			munmap(Aligned + Size, Tail);
+		}
+		return Aligned;
+	}
+
+	void* AllocateHuge(size_t Size, u32* Pages)
+	{
+		size_t MappedSize = (Size + AllocationHeader + HugePageSize - 1) & ~(HugePageSize - 1);
+		u32 Kind = PAGES_HUGE;
+		u8* Base = (u8*)mmap(nullptr, MappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (Base == MAP_FAILED)
+		{
+			// no hugetlbfs pages set aside, which is usual, so ask for transparent ones
+			Base = MapHugeAligned(MappedSize, PROT_READ | PROT_WRITE, 0);
+			if (!Base)
+				return nullptr;
+			Kind = madvise(Base, MappedSize, MADV_HUGEPAGE) ? PAGES_NORMAL : PAGES_TRANSPARENT;
+		}
+
+		*(size_t*)Base = MappedSize;
+		if (Pages)
+		{
+			*Pages = Kind;
+		}
+		return Base + AllocationHeader;
+	}
+
+	void* ReserveHuge(size_t Size, u32* Pages)
+	{
+		u8* Base = MapHugeAligned(Size, PROT_NONE, MAP_NORESERVE);
+		if (Pages)
+		{
+			*Pages = Base && !madvise(Base, Size, MADV_HUGEPAGE) ? PAGES_TRANSPARENT : PAGES_NORMAL;
+		}
+		return Base;
+	}
+
+	// the kernel only says in smaps, which lists every mapping with its huge page counts in kB
+	size_t GetHugePageBytes(const void* Memory, size_t Size)
+	{
+		FILE* Maps;
+		if (fopen_s(&Maps, "/proc/self/smaps", "r"))
+			return 0;
+
+		size_t Begin = (size_t)Memory;
+		size_t End = Begin + Size;
+		size_t Total = 0;
+		bool Inside = false;
+		char Line[256];
+		while (fgets(Line, sizeof(Line), Maps))
+		{
+			unsigned long long MapBegin, MapEnd, Kilobytes;
+			if (sscanf(Line, "%llx-%llx ", &MapBegin, &MapEnd) == 2)
+			{
+				Inside = MapBegin < End && MapEnd > Begin;
+			}
+			else if (Inside && (sscanf(Line, "AnonHugePages: %llu kB", &Kilobytes) == 1 || sscanf(Line, "Private_Hugetlb: %llu kB", &Kilobytes) == 1))
+			{
+				Total += (size_t)Kilobytes * 1024;
+			}
+		}
+		fclose(Maps);
+		return min(Total, Size);
+	}
+
+	static void* ThreadEntry(void* Parameter)
+	{
+		Thread* thread = (Thread*)Parameter;
+		thread->Function(thread->Data);
+		// whatever blocks the thread freed go back to the heap rather than leaving with it
+		Heap::FlushThreadCache();
+		return nullptr;
+	}
+
+	bool Thread::Start(ThreadFunction* InFunction, void* InData)
+	{
+		Function = InFunction;
+		Data = InData;
+		pthread_t Id;
+		if (pthread_create(&Id, nullptr, ThreadEntry, this))
+		{
+			Handle = nullptr;
+			return false;
+		}
+		Handle = (void*)Id;
+		return true;
+	}
+
+	void Thread::Join()
+	{
+		if (Handle)
+		{
+			pthread_join((pthread_t)Handle, nullptr);
+			Handle = nullptr;
+		}
+	}
+
+	bool Semaphore::Create(u32 InitialCount)
+	{
+		Handle = Allocate(sizeof(sem_t));
+		if (Handle && !sem_init((sem_t*)Handle, 0, InitialCount))
+			return true;
+		Free(Handle);
+		Handle = nullptr;
+		return false;
+	}
+
+	void Semaphore::Signal(u32 Count)
+	{
+		while (Count--)
+		{
+			sem_post((sem_t*)Handle);
+		}
+	}
+
+	void Semaphore::Wait()
+	{
+		while (sem_wait((sem_t*)Handle) && errno == EINTR)
+		{
+		}
+	}
+
+	void Semaphore::Release()
+	{
+		if (Handle)
+		{
+			sem_destroy((sem_t*)Handle);
+			Free(Handle);
+			Handle = nullptr;
+		}
+	}
+
+	void SleepSeconds(double Seconds)
+	{
+		timespec Sleep = { (time_t)Seconds, (long)((Seconds - (time_t)Seconds) * 1e9) };
+		while (nanosleep(&Sleep, &Sleep) && errno == EINTR)
+		{
+		}
+	}
+
+	u32 GetProcessorCount()
+	{
+		long Count = sysconf(_SC_NPROCESSORS_ONLN);
+		return Count > 0 ? (u32)Count : 1;
+	}
+
+	void Show(u32* Buffer, int Width, int Height, const Bitmap::Rect* Dirty, u32 DirtyCount)
+	{
+		if (CurrentSink)
+		{
+			CurrentSink->PresentDamage(Buffer, Width, Height, Dirty, DirtyCount);
+		}
+	}
+
+	void DebugOut(const str8& message)
+	{
+		write(STDERR_FILENO, message.chars, message.len);
+	}
+
+	void Print(const str8& message)
+	{
+		write(STDOUT_FILENO, message.chars, message.len);
+	}
+};
+
+#endif
@@ -27,7 +27,7 @@ namespace Jogo
 		__m128 m = _mm_set_ss(n);
 		s32 i = _mm_cvtt_ss2si(m);
 		m = _mm_cvt_si2ss(m, i);
-		float tn = m.m128_f32[0];
+		float tn = _mm_cvtss_f32(m);
 		if (n < 0 && tn != n)
 		{
 			tn -= 1.0f;
@@ -40,7 +40,7 @@ namespace Jogo
 		__m128 m = _mm_set_ss(n);
 		s32 i = _mm_cvtt_ss2si(m);
 		m = _mm_cvt_si2ss(m, i);
-		float tn = m.m128_f32[0];
+		float tn = _mm_cvtss_f32(m);
 		if (n > 0 && tn != n)
 		{
 			tn += 1.0f;
@@ -80,7 +80,7 @@ namespace Jogo
 	{
 		__m128 m = _mm_set_ss(x);
 		m = _mm_sqrt_ss(m);
-		return m.m128_f32[0];
+		return _mm_cvtss_f32(m);
 	}
 
 	void remainder(float num, float denom, float invdenom, int& quotient, float& remainder)
@@ -0,0 +1,183 @@
+#include "Jogo.h"
+#include "MemoryReport.h"
+
+void Arena::RecordAllocation(size_t Request, const char* Site)
+{
+	ArenaStats& s = *Stats;
+	size_t Used = (size_t)(CurrentLocation - BaseAddress);
+	s.Peak = Jogo::max(s.Peak, Used);
+	s.FramePeak = Jogo::max(s.FramePeak, Used);
+	s.TotalAllocs++;
+	s.FrameAllocs++;
+	s.FrameBytes += Request;
+
+	if (!Site)
+	{
+		Site = "other";
+	}
+
+	// sites are string literals, so the pointer is the key
+	u32 i = 0;
+	while (i < s.NumSites && s.Sites[i].Site != Site)
+		i++;
+	if (i == s.NumSites)
+	{
+		if (s.NumSites < ArenaStats::MaxSites)
+		{
+			s.Sites[s.NumSites++] = { Site };
+		}
+		else
+		{
+			i = ArenaStats::MaxSites - 1;
+		}
+	}
+	s.Sites[i].Count++;
+	s.Sites[i].Bytes += Request;
+	s.Sites[i].TotalBytes += Request;
+}
+
+namespace Jogo
+{
+	namespace MemoryReport
+	{
+		static const u32 MaxTracked = 8;
+		ArenaStats Tracked[MaxTracked];
+
+		bool Track(Arena& Memory, const char* Name)
+		{
+			if (Memory.Stats)
+				return true;
+
+			for (u32 i = 0; i < MaxTracked; i++)
+			{
+				ArenaStats& s = Tracked[i];
+				if (!s.Name)
+				{
+					s = {};
+					s.Name = Name;
+					s.BaseAddress = Memory.BaseAddress;
+					s.Pages = Memory.Pages;
+					strcpy_s(s.CounterName, sizeof(s.CounterName), Name);
+					strcat_s(s.CounterName, sizeof(s.CounterName), " bytes");
+					Memory.Stats = &s;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Untrack(Arena& Memory)
+		{
+			if (Memory.Stats)
+			{
+				Memory.Stats->Name = nullptr;
+				Memory.Stats = nullptr;
+			}
+		}
+
+		void EndFrame()
+		{
+			for (u32 i = 0; i < MaxTracked; i++)
+			{
+				ArenaStats& s = Tracked[i];
+				if (!s.Name)
+					continue;
+
+				JOGO_COUNTER(s.CounterName, s.FrameBytes);
+				s.LastAllocs = s.FrameAllocs;
+				s.LastBytes = s.FrameBytes;
+				s.LastPeak = s.FramePeak;
+				s.FrameAllocs = 0;
+				s.FrameBytes = 0;
+				s.FramePeak = 0;
+				for (u32 j = 0; j < s.NumSites; j++)
+				{
+					s.Sites[j].LastCount = s.Sites[j].Count;
+					s.Sites[j].LastBytes = s.Sites[j].Bytes;
+					s.Sites[j].Count = 0;
+					s.Sites[j].Bytes = 0;
+				}
+			}
+		}
+
+		u32 GetTrackedCount()
+		{
+			return MaxTracked;
+		}
+
+		const ArenaStats& GetStats(u32 Index)
+		{
+			return Tracked[Index < MaxTracked ? Index : 0];
+		}
+
+		static float Kilobytes(size_t Bytes)
+		{
+			return (float)Bytes / 1024.0f;
+		}
+
+		// just the file name and line of a JOGO_ALLOCATE site
+		static const char* ShortSite(const char* Site)
+		{
+			const char* Short = Site;
+			for (const char* c = Site; *c; c++)
+			{
+				if (*c == '/' || *c == '\\')
+					Short = c + 1;
+			}
+			return Short;
+		}
+
+		void DrawOverlay(Bitmap& Target, Font& TextFont, s32 x, s32 y, Arena& arena)
+		{
+			static const u32 SitesShown = 3;
+
+			s32 LineHeight = (s32)TextFont.CharacterHeight;
+			s32 Width = 66 * (s32)TextFont.CharacterWidth;
+			for (u32 i = 0; i < MaxTracked; i++)
+			{
+				const ArenaStats& s = Tracked[i];
+				if (!s.Name)
+					continue;
+
+				// busiest sites by last frame's bytes
+				u32 Shown[SitesShown];
+				u32 NumShown = 0;
+				for (u32 j = 0; j < s.NumSites; j++)
+				{
+					if (!s.Sites[j].LastCount)
+						continue;
+
+					size_t Bytes = s.Sites[j].LastBytes;
+					u32 k = NumShown;
+					if (k == SitesShown)
+					{
+						if (Bytes <= s.Sites[Shown[k - 1]].LastBytes)
+							continue;
+						k--;
+					}
+					else
+					{
+						NumShown++;
+					}
+					for (; k > 0 && s.Sites[Shown[k - 1]].LastBytes < Bytes; k--)
+					{
+						Shown[k] = Shown[k - 1];
+					}
+					Shown[k] = j;
+				}
+
+				Target.FillRect({ x, y, Width, (s32)(NumShown + 1) * LineHeight }, 0);
+				TextFont.DrawText(x, y, str8::format(arena, "{}{}: peak {:0.1} KB, frame {} allocs {:0.1} KB, high {:0.1} KB",
+					s.Name, s.Pages == PAGES_NORMAL ? "" : " (2MB)", Kilobytes(s.Peak), s.LastAllocs, Kilobytes(s.LastBytes), Kilobytes(s.LastPeak)), 0x00ffff, 0xff000000, Target);
+				y += LineHeight;
+				for (u32 j = 0; j < NumShown; j++)
+				{
+					const ArenaSite& Site = s.Sites[Shown[j]];
+					TextFont.DrawText(x + 2 * (s32)TextFont.CharacterWidth, y, str8::format(arena, "{} x{} {:0.1} KB",
+						ShortSite(Site.Site), Site.LastCount, Kilobytes(Site.LastBytes)), 0xffffff, 0xff000000, Target);
+					y += LineHeight;
+				}
+			}
+		}
+	};
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include "int_types.h"
+
+struct Arena;
+struct Bitmap;
+struct Font;
+
+// one call site's allocations, sites are JOGO_ALLOCATE's file:line strings and plain Allocate counts as "other"
+struct ArenaSite
+{
+	const char* Site;
+	u32 Count;			// this frame
+	size_t Bytes;
+	u32 LastCount;		// last frame, what the report shows
+	size_t LastBytes;
+	size_t TotalBytes;
+};
+
+struct ArenaStats
+{
+	static const u32 MaxSites = 32;
+
+	const char* Name;
+	u8* BaseAddress;
+	u32 Pages;				// the arena's Jogo::PageKind
+	size_t Peak;			// most ever in use, measured from BaseAddress at each allocation
+	u64 TotalAllocs;
+
+	u32 FrameAllocs;
+	size_t FrameBytes;
+	size_t FramePeak;
+
+	u32 LastAllocs;
+	size_t LastBytes;
+	size_t LastPeak;
+
+	ArenaSite Sites[MaxSites];	// past MaxSites everything goes to the last one
+	u32 NumSites;
+
+	char CounterName[64];		// for the profiler, which keeps the pointer
+};
+
+namespace Jogo
+{
+	namespace MemoryReport
+	{
+		// counts every allocation from Memory from now on under Name, which must be a string literal
+		// costs one untaken branch per Allocate for arenas that aren't tracked
+		bool Track(Arena& Memory, const char* Name);
+		void Untrack(Arena& Memory);
+
+		// called by Jogo::Run after every Draw, this frame's numbers become the ones the report shows
+		// and each arena's bytes allocated this frame go to the profiler as a counter
+		void EndFrame();
+
+		u32 GetTrackedCount();
+		const ArenaStats& GetStats(u32 Index);
+
+		// every tracked arena's last frame, with its three busiest call sites
+		void DrawOverlay(Bitmap& Target, Font& TextFont, s32 x, s32 y, Arena& arena);
+	};
+};
@@ -0,0 +1,191 @@
+#include "Jogo.h"
+#include "Pacing.h"
+
+namespace Jogo
+{
+	namespace Pacing
+	{
+		// the OS wakes us late by an unknown amount, so sleep short of the deadline by the worst lateness
+		// seen recently and spin the rest
+		static const double MinSpinMargin = 0.0002;
+		static const double MaxSpinMargin = 0.004;
+
+		u64 Period = 0;
+		u64 Deadline = 0;
+		u64 LastFrame = 0;
+		double SpinMargin = 0.001;
+
+		bool Resumed = false;
+		bool Skipped = false;
+		float ElapsedSeconds = 0;
+
+		float FixedStep = 0;
+		u32 MaxSteps = 8;
+		float Accumulator = 0;
+
+		float History[HistorySize];
+		u32 HistoryCount = 0;
+		u32 HistoryNext = 0;
+		u32 MissedFrames = 0;
+
+		void SetFixedTimestep(float StepSeconds, u32 MaxStepsPerFrame)
+		{
+			FixedStep = StepSeconds > 0 ? StepSeconds : 0;
+			MaxSteps = MaxStepsPerFrame ? MaxStepsPerFrame : 1;
+			Accumulator = 0;
+		}
+
+		float GetFixedTimestep()
+		{
+			return FixedStep;
+		}
+
+		float GetInterpolation()
+		{
+			return FixedStep > 0 ? Accumulator / FixedStep : 1.0f;
+		}
+
+		void ResetFrameStats()
+		{
+			HistoryCount = 0;
+			HistoryNext = 0;
+			MissedFrames = 0;
+		}
+
+		static void AddFrameTime(float Milliseconds)
+		{
+			History[HistoryNext] = Milliseconds;
+			HistoryNext = (HistoryNext + 1) % HistorySize;
+			HistoryCount = min(HistoryCount + 1, HistorySize);
+		}
+
+		FrameStats GetFrameStats()
+		{
+			FrameStats Stats = {};
+			Stats.Frames = HistoryCount;
+			Stats.Missed = MissedFrames;
+			if (!HistoryCount)
+				return Stats;
+
+			float Sorted[HistorySize];
+			float Total = 0;
+			for (u32 i = 0; i < HistoryCount; i++)
+			{
+				Sorted[i] = History[i];
+				Total += History[i];
+			}
+
+			// shell sort, only runs when someone asks
+			for (u32 Gap = HistoryCount / 2; Gap > 0; Gap /= 2)
+			{
+				for (u32 i = Gap; i < HistoryCount; i++)
+				{
+					float Value = Sorted[i];
+					u32 j = i;
+					for (; j >= Gap && Sorted[j - Gap] > Value; j -= Gap)
+					{
+						Sorted[j] = Sorted[j - Gap];
+					}
+					Sorted[j] = Value;
+				}
+			}
+
+			Stats.P50 = Sorted[(HistoryCount - 1) / 2];
+			Stats.P99 = Sorted[(HistoryCount - 1) * 99 / 100];
+			Stats.Max = Sorted[HistoryCount - 1];
+			Stats.Average = Total / HistoryCount;
+			return Stats;
+		}
+
+		void BeginRun(int TargetFPS)
+		{
+			u64 Now = Timer::GetTicks();
+			Period = TargetFPS > 0 ? Timer::Frequency / TargetFPS : 0;
+			Deadline = Now + Period;
+			LastFrame = Now;
+			Accumulator = 0;
+			ResetFrameStats();
+		}
+
+		void Resume()
+		{
+			Resumed = true;
+		}
+
+		void Skip()
+		{
+			Skipped = true;
+		}
+
+		float WaitForFrame()
+		{
+			u64 Now = Timer::GetTicks();
+			if (Resumed || Skipped)
+			{
+				Deadline = Now + Period;
+				float Seconds = Skipped ? 0.0f : (float)((double)(Now - LastFrame) / Timer::Frequency);
+				LastFrame = Now;
+				Resumed = Skipped = false;
+				return Seconds;
+			}
+
+			if (Period)
+			{
+				if (Now < Deadline)
+				{
+					double SecondsLeft = (double)(Deadline - Now) / Timer::Frequency;
+					if (SecondsLeft > SpinMargin)
+					{
+						double Request = SecondsLeft - SpinMargin;
+						SleepSeconds(Request);
+
+						u64 Woke = Timer::GetTicks();
+						double Late = (double)(Woke - Now) / Timer::Frequency - Request;
+						SpinMargin = clamp(max(SpinMargin * 0.99, Late * 1.5), MinSpinMargin, MaxSpinMargin);
+					}
+
+					while (Timer::GetTicks() < Deadline)
+					{
+						SpinPause();
+					}
+					Now = Timer::GetTicks();
+				}
+
+				// stay on the same grid of deadlines unless we fell a whole period behind
+				Deadline += Period;
+				if (Deadline <= Now)
+				{
+					Deadline = Now + Period;
+					MissedFrames++;
+				}
+			}
+
+			float Seconds = (float)((double)(Now - LastFrame) / Timer::Frequency);
+			LastFrame = Now;
+			AddFrameTime(Seconds * 1000.0f);
+			return Seconds;
+		}
+
+		u32 GetSteps(float FrameSeconds, float& DeltaTime)
+		{
+			ElapsedSeconds = FrameSeconds;
+			if (FixedStep <= 0)
+			{
+				DeltaTime = clamp(FrameSeconds, 0.0f, MaxDeltaTime);
+				return 1;
+			}
+
+			// drop time we could never catch up on rather than spiral
+			Accumulator += min(FrameSeconds, FixedStep * MaxSteps);
+			u32 Steps = (u32)(Accumulator / FixedStep);
+			Accumulator -= Steps * FixedStep;
+			DeltaTime = FixedStep;
+			return Steps;
+		}
+
+		float GetElapsedSeconds()
+		{
+			return ElapsedSeconds;
+		}
+	};
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "int_types.h"
+
+namespace Jogo
+{
+	namespace Pacing
+	{
+		// Tick never sees more than this in variable mode, so a breakpoint doesn't launch everything off screen
+		static const float MaxDeltaTime = 0.1f;
+
+		// StepSeconds > 0 switches Run to a fixed timestep: Tick is called zero or more times per frame with
+		// exactly StepSeconds, as many times as the elapsed time covers, but at most MaxStepsPerFrame
+		// StepSeconds = 0 goes back to one Tick per frame with the measured frame time
+		void SetFixedTimestep(float StepSeconds, u32 MaxStepsPerFrame = 8);
+		float GetFixedTimestep();
+
+		// how far into the next fixed step the frame is being drawn, 0..1, for interpolating positions in Draw
+		float GetInterpolation();
+
+		// frame times over the last HistorySize frames, in milliseconds
+		static const u32 HistorySize = 1024;
+
+		struct FrameStats
+		{
+			float P50;
+			float P99;
+			float Max;
+			float Average;
+			u32 Frames;		// frames in the history, up to HistorySize
+			u32 Missed;		// frames that started more than a whole period late, since the last reset
+		};
+
+		FrameStats GetFrameStats();
+		void ResetFrameStats();
+
+		// called by Jogo::Run
+		// TargetFPS = 0 doesn't wait at all, WaitForFrame just measures
+		void BeginRun(int TargetFPS);
+
+		// sleeps most of the way to the next frame's deadline, then spins on the timer for the rest
+		// returns the seconds since the previous frame started
+		float WaitForFrame();
+
+		// Run was idle waiting for input: the next frame starts right away, isn't a missed deadline, and stays out of
+		// the stats. Its DT is still clamped, GetElapsedSeconds has all of the time that passed
+		void Resume();
+
+		// Run was paused in the background: the time that passed is dropped, the next frame starts right away as
+		// if the previous one had just ended
+		void Skip();
+
+		// turns a frame's elapsed time into the number of Ticks to run and the DT to pass each of them
+		u32 GetSteps(float FrameSeconds, float& DeltaTime);
+
+		// the real seconds the current frame covers, never clamped and including any time Run sat idle before it,
+		// for an on demand app's timers that have to keep wall clock time, like the UI cursor blink
+		float GetElapsedSeconds();
+	};
+};
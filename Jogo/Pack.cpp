@@ -0,0 +1,114 @@
+#include "Jogo.h"
+#include "Pack.h"
+
+namespace Jogo
+{
+	Pack Pack::Open(const char* Filename)
+	{
+		Pack NewPack = {};
+		if (!MapFile(Filename, NewPack.File))
+			return NewPack;
+
+		// only the tables' bounds are checked here, each entry's when it's asked for
+		const PackHeader* Header = (const PackHeader*)NewPack.File.Data;
+		u64 Size = NewPack.File.Size;
+		bool Valid = Size >= sizeof(PackHeader) && Header->Magic == PackHeader::MagicValue &&
+			Header->Version == PackHeader::CurrentVersion && Header->FileSize == Size &&
+			Header->SlotCount && !(Header->SlotCount & (Header->SlotCount - 1)) && Header->EntryCount < Header->SlotCount &&
+			Header->EntriesOffset + (u64)Header->EntryCount * sizeof(PackEntry) <= Size &&
+			Header->SlotsOffset + (u64)Header->SlotCount * sizeof(u32) <= Size && Header->NamesOffset <= Size;
+		if (!Valid)
+		{
+			UnmapFile(NewPack.File);
+			return NewPack;
+		}
+
+		NewPack.Header = Header;
+		return NewPack;
+	}
+
+	void Pack::Close()
+	{
+		UnmapFile(File);
+		Header = nullptr;
+	}
+
+	const PackEntry* Pack::Find(const str8& Name) const
+	{
+		if (!Header)
+			return nullptr;
+
+		const PackEntry* Entries = (const PackEntry*)(File.Data + Header->EntriesOffset);
+		const u32* Slots = (const u32*)(File.Data + Header->SlotsOffset);
+		u32 Hash = HashKey(Name);
+		u32 Mask = Header->SlotCount - 1;
+		for (u32 i = Hash & Mask; Slots[i]; i = (i + 1) & Mask)
+		{
+			if (Slots[i] > Header->EntryCount)
+				return nullptr;
+
+			const PackEntry& Entry = Entries[Slots[i] - 1];
+			if (Entry.Hash == Hash && Entry.NameLength == Name.len && Entry.NameOffset + Name.len <= File.Size &&
+				!memcmp(File.Data + Entry.NameOffset, Name.chars, Name.len))
+				return &Entry;
+		}
+		return nullptr;
+	}
+
+	static bool GetEntryBitmap(const MappedFile& File, const PackEntry& Entry, Bitmap& Result)
+	{
+		if (Entry.Pitch < Entry.Width * Entry.PixelSize || Entry.PixelsOffset + (u64)Entry.Pitch * Entry.Height > File.Size)
+			return false;
+
+		Result = { Entry.Width, Entry.Height, Entry.PixelSize, Entry.Pitch };
+		Result.Pixels = File.Data + Entry.PixelsOffset;
+		return true;
+	}
+
+	bool Pack::GetBitmap(const str8& Name, Bitmap& Result) const
+	{
+		const PackEntry* Entry = Find(Name);
+		return Entry && Entry->Kind == PACK_BITMAP && GetEntryBitmap(File, *Entry, Result);
+	}
+
+	bool Pack::GetFont(const str8& Name, Font& Result) const
+	{
+		const PackEntry* Entry = Find(Name);
+		if (!Entry || Entry->Kind != PACK_FONT)
+			return false;
+
+		Font NewFont = {};
+		if (!GetEntryBitmap(File, *Entry, NewFont.FontBitmap))
+			return false;
+
+		if (Entry->RectsOffset)
+		{
+			if (Entry->RectsOffset + (u64)Entry->CharacterCount * sizeof(Bitmap::Rect) > File.Size)
+				return false;
+			NewFont.CharacterRects = (Bitmap::Rect*)(File.Data + Entry->RectsOffset);
+		}
+		NewFont.CharacterMin = Entry->CharacterMin;
+		NewFont.CharacterCount = Entry->CharacterCount;
+		NewFont.CharacterWidth = Entry->CharacterWidth;
+		NewFont.CharacterHeight = Entry->CharacterHeight;
+		NewFont.Antialiased = Entry->Antialiased != 0;
+		Result = NewFont;
+		return true;
+	}
+
+	Bitmap Pack::LoadBitmap(const char* Name, Arena& arena) const
+	{
+		Bitmap Result;
+		if (GetBitmap(str8(Name, str8::cstringlength(Name)), Result))
+			return Result;
+		return Bitmap::Load(Name, arena);
+	}
+
+	Font Pack::LoadFont(const char* Name, Arena& arena) const
+	{
+		Font Result;
+		if (GetFont(str8(Name, str8::cstringlength(Name)), Result))
+			return Result;
+		return Font::Load(Name, arena);
+	}
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include "int_types.h"
+#include "Platform.h"
+#include "Bitmap.h"
+#include "Font.h"
+#include "str8.h"
+
+namespace Jogo
+{
+	// a JogoPack holds an app's bitmaps and fonts in one file, written offline by the JogoPack tool
+	// the pixels are already converted and laid out as Bitmap::Create(..., true) would, rows padded to
+	// Bitmap::RowAlignment and every blob starting on it, so at runtime the file is mapped and a Bitmap or Font
+	// points straight into it; the name table is hashed by the packer too, so opening reads nothing but the header
+	//
+	// the file is a PackHeader, EntryCount PackEntries, SlotCount u32 slots, the names, then the blobs
+	// all offsets are from the start of the file
+	struct PackHeader
+	{
+		static const u32 MagicValue = 0x4b41504a;	// "JPAK"
+		static const u32 CurrentVersion = 1;
+
+		u32 Magic;
+		u32 Version;
+		u32 EntryCount;
+		u32 SlotCount;			// power of 2, open addressing by HashKey(Name) with linear probing
+		u64 EntriesOffset;
+		u64 SlotsOffset;		// each an entry index + 1, 0 for empty
+		u64 NamesOffset;
+		u64 FileSize;
+	};
+
+	enum PackEntryKind : u32
+	{
+		PACK_BITMAP,
+		PACK_FONT,				// the bitmap fields are its FontBitmap
+	};
+
+	struct PackEntry
+	{
+		u32 Kind;
+		u32 Hash;				// HashKey of the name, checked before the characters are
+		u64 NameOffset;			// null terminated
+		u32 NameLength;
+
+		u32 Width;
+		u32 Height;
+		u32 PixelSize;
+		u32 Pitch;
+		u64 PixelsOffset;
+
+		u32 CharacterMin;
+		u32 CharacterCount;
+		u32 CharacterWidth;
+		u32 CharacterHeight;
+		u32 Antialiased;
+		u64 RectsOffset;		// CharacterCount Bitmap::Rects, 0 for a fixed width font
+	};
+
+	// the open file's mapping lives until Close, as do the Bitmaps and Fonts it hands out
+	// their pixels are copy on write, so drawing into one changes this process's copy and never the file
+	struct Pack
+	{
+		MappedFile File;
+		const PackHeader* Header;	// nullptr when no pack is open
+
+		// an empty Pack if the file is missing or isn't a pack of this version
+		static Pack Open(const char* Filename);
+		void Close();
+
+		const PackEntry* Find(const str8& Name) const;
+		bool GetBitmap(const str8& Name, Bitmap& Result) const;
+		bool GetFont(const str8& Name, Font& Result) const;
+
+		// from the pack when it has Name, otherwise from the loose file Name is the path of
+		// packs are named by the same paths, so an app reads the same assets either way
+		Bitmap LoadBitmap(const char* Name, Arena& arena) const;
+		Font LoadFont(const char* Name, Arena& arena) const;
+	};
+};
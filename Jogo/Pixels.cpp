@@ -0,0 +1,722 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Pixels.h"
+
+namespace Jogo
+{
+	namespace Pixels
+	{
+		static Level GetCPULevel()
+		{
+			return GetCPUFeatures().AVX2 ? LEVEL_AVX2 : LEVEL_SSE2;
+		}
+
+		static Level GetStartLevel()
+		{
+			Level CPULevel = GetCPULevel();
+			const char* Setting = getenv("JOGO_SIMD");
+			if (Setting && !strcmp(Setting, "scalar"))
+				return LEVEL_SCALAR;
+			if (Setting && !strcmp(Setting, "sse2"))
+				return LEVEL_SSE2;
+			return CPULevel;
+		}
+
+		Level CurrentLevel = GetStartLevel();
+
+		Level GetLevel()
+		{
+			return CurrentLevel;
+		}
+
+		void SetLevel(Level NewLevel)
+		{
+			Level CPULevel = GetCPULevel();
+			CurrentLevel = NewLevel < CPULevel ? NewLevel : CPULevel;
+		}
+
+		void EndStream()
+		{
+			_mm_sfence();
+		}
+
+		void FillRow32Scalar(u32* Row, u32 Color, size_t Count, bool Stream)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				Row[i] = Color;
+			}
+		}
+
+		void FillRow32SSE2(u32* Row, u32 Color, size_t Count, bool Stream)
+		{
+			// single pixels up to a 16 byte boundary, rows of a 32bpp bitmap are at least 4 byte aligned
+			while (Count && ((size_t)Row & 15))
+			{
+				*Row++ = Color;
+				Count--;
+			}
+
+			__m128i Fill = _mm_set1_epi32((int)Color);
+			__m128i* Dest = (__m128i*)Row;
+			size_t Blocks = Count / 16;
+			if (Stream)
+			{
+				for (size_t i = 0; i < Blocks; i++, Dest += 4)
+				{
+					_mm_stream_si128(Dest, Fill);
+					_mm_stream_si128(Dest + 1, Fill);
+					_mm_stream_si128(Dest + 2, Fill);
+					_mm_stream_si128(Dest + 3, Fill);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < Blocks; i++, Dest += 4)
+				{
+					_mm_store_si128(Dest, Fill);
+					_mm_store_si128(Dest + 1, Fill);
+					_mm_store_si128(Dest + 2, Fill);
+					_mm_store_si128(Dest + 3, Fill);
+				}
+			}
+			for (size_t i = 0; i < (Count & 15) / 4; i++)
+			{
+				_mm_store_si128(Dest++, Fill);
+			}
+
+			Row = (u32*)Dest;
+			for (size_t i = 0; i < (Count & 3); i++)
+			{
+				Row[i] = Color;
+			}
+		}
+
+		JOGO_TARGET("avx2")
+		void FillRow32AVX2(u32* Row, u32 Color, size_t Count, bool Stream)
+		{
+			while (Count && ((size_t)Row & 31))
+			{
+				*Row++ = Color;
+				Count--;
+			}
+
+			__m256i Fill = _mm256_set1_epi32((int)Color);
+			__m256i* Dest = (__m256i*)Row;
+			size_t Blocks = Count / 32;
+			if (Stream)
+			{
+				for (size_t i = 0; i < Blocks; i++, Dest += 4)
+				{
+					_mm256_stream_si256(Dest, Fill);
+					_mm256_stream_si256(Dest + 1, Fill);
+					_mm256_stream_si256(Dest + 2, Fill);
+					_mm256_stream_si256(Dest + 3, Fill);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < Blocks; i++, Dest += 4)
+				{
+					_mm256_store_si256(Dest, Fill);
+					_mm256_store_si256(Dest + 1, Fill);
+					_mm256_store_si256(Dest + 2, Fill);
+					_mm256_store_si256(Dest + 3, Fill);
+				}
+			}
+			for (size_t i = 0; i < (Count & 31) / 8; i++)
+			{
+				_mm256_store_si256(Dest++, Fill);
+			}
+
+			Row = (u32*)Dest;
+			for (size_t i = 0; i < (Count & 7); i++)
+			{
+				Row[i] = Color;
+			}
+			_mm256_zeroupper();
+		}
+
+		void ExpandMask32Scalar(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque)
+		{
+			if (Opaque)
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					Row[i] = Mask[i] ? Color : BkColor;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					if (Mask[i])
+					{
+						Row[i] = Color;
+					}
+				}
+			}
+		}
+
+		void ExpandMask32SSE2(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque)
+		{
+			// 16 mask bytes at a time, compared against 0 and widened twice to a 32 bit select per pixel
+			__m128i Zero = _mm_setzero_si128();
+			__m128i Fore = _mm_set1_epi32((int)Color);
+			__m128i Back = _mm_set1_epi32((int)BkColor);
+			size_t Blocks = Count / 16;
+			for (size_t i = 0; i < Blocks; i++, Row += 16, Mask += 16)
+			{
+				__m128i Clear = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)Mask), Zero);
+				__m128i Low = _mm_unpacklo_epi8(Clear, Clear);
+				__m128i High = _mm_unpackhi_epi8(Clear, Clear);
+				__m128i Select[4] = { _mm_unpacklo_epi16(Low, Low), _mm_unpackhi_epi16(Low, Low), _mm_unpacklo_epi16(High, High), _mm_unpackhi_epi16(High, High) };
+				for (u32 j = 0; j < 4; j++)
+				{
+					__m128i* Dest = (__m128i*)Row + j;
+					__m128i Under = Opaque ? Back : _mm_loadu_si128(Dest);
+					_mm_storeu_si128(Dest, _mm_or_si128(_mm_and_si128(Select[j], Under), _mm_andnot_si128(Select[j], Fore)));
+				}
+			}
+
+			// glyphs are often 8 wide, so half a block gets the vector path too
+			if (Count & 8)
+			{
+				__m128i Clear = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i*)Mask), Zero);
+				__m128i Low = _mm_unpacklo_epi8(Clear, Clear);
+				__m128i Select[2] = { _mm_unpacklo_epi16(Low, Low), _mm_unpackhi_epi16(Low, Low) };
+				for (u32 j = 0; j < 2; j++)
+				{
+					__m128i* Dest = (__m128i*)Row + j;
+					__m128i Under = Opaque ? Back : _mm_loadu_si128(Dest);
+					_mm_storeu_si128(Dest, _mm_or_si128(_mm_and_si128(Select[j], Under), _mm_andnot_si128(Select[j], Fore)));
+				}
+				Row += 8;
+				Mask += 8;
+			}
+			ExpandMask32Scalar(Row, Mask, Count & 7, Color, BkColor, Opaque);
+		}
+
+		JOGO_TARGET("avx2")
+		void ExpandMask32AVX2(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque)
+		{
+			// 8 mask bytes widened straight to 8 32 bit lanes, 16 a time
+			__m256i Zero = _mm256_setzero_si256();
+			__m256i Fore = _mm256_set1_epi32((int)Color);
+			__m256i Back = _mm256_set1_epi32((int)BkColor);
+			size_t Blocks = Count / 16;
+			for (size_t i = 0; i < Blocks; i++, Row += 16, Mask += 16)
+			{
+				for (u32 j = 0; j < 2; j++)
+				{
+					__m256i* Dest = (__m256i*)Row + j;
+					__m256i Clear = _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(Mask + j * 8))), Zero);
+					__m256i Under = Opaque ? Back : _mm256_loadu_si256(Dest);
+					_mm256_storeu_si256(Dest, _mm256_blendv_epi8(Fore, Under, Clear));
+				}
+			}
+			if (Count & 8)
+			{
+				__m256i Clear = _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)Mask)), Zero);
+				__m256i Under = Opaque ? Back : _mm256_loadu_si256((__m256i*)Row);
+				_mm256_storeu_si256((__m256i*)Row, _mm256_blendv_epi8(Fore, Under, Clear));
+				Row += 8;
+				Mask += 8;
+			}
+			_mm256_zeroupper();
+			ExpandMask32Scalar(Row, Mask, Count & 7, Color, BkColor, Opaque);
+		}
+
+		void ExpandMask32(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				ExpandMask32AVX2(Row, Mask, Count, Color, BkColor, Opaque);
+				break;
+			case LEVEL_SSE2:
+				ExpandMask32SSE2(Row, Mask, Count, Color, BkColor, Opaque);
+				break;
+			default:
+				ExpandMask32Scalar(Row, Mask, Count, Color, BkColor, Opaque);
+				break;
+			}
+		}
+
+		void ScaleRow32Scalar(u32* Row, const u32* Source, size_t Count, u32 x, u32 dx)
+		{
+			for (size_t i = 0; i < Count; i++, x += dx)
+			{
+				Row[i] = Source[x >> 16];
+			}
+		}
+
+		JOGO_TARGET("avx2")
+		void ScaleRow32AVX2(u32* Row, const u32* Source, size_t Count, u32 x, u32 dx)
+		{
+			// eight positions a step, gathered by their integer parts
+			__m256i Positions = _mm256_add_epi32(_mm256_set1_epi32((int)x), _mm256_mullo_epi32(_mm256_set1_epi32((int)dx), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+			__m256i Step = _mm256_set1_epi32((int)(dx * 8));
+			size_t Blocks = Count / 8;
+			for (size_t i = 0; i < Blocks; i++, Row += 8)
+			{
+				__m256i Texels = _mm256_i32gather_epi32((const int*)Source, _mm256_srli_epi32(Positions, 16), 4);
+				_mm256_storeu_si256((__m256i*)Row, Texels);
+				Positions = _mm256_add_epi32(Positions, Step);
+			}
+			_mm256_zeroupper();
+			ScaleRow32Scalar(Row, Source, Count & 7, x + (u32)(Blocks * 8) * dx, dx);
+		}
+
+		void ScaleRow32(u32* Row, const u32* Source, size_t Count, u32 x, u32 dx)
+		{
+			if (CurrentLevel == LEVEL_AVX2)
+			{
+				ScaleRow32AVX2(Row, Source, Count, x, dx);
+			}
+			else
+			{
+				ScaleRow32Scalar(Row, Source, Count, x, dx);
+			}
+		}
+
+		// x / 255 rounded, exact for x up to 255 * 255
+		static u32 Div255(u32 x)
+		{
+			x += 128;
+			return (x + (x >> 8)) >> 8;
+		}
+
+		static __m128i Div255(__m128i x)
+		{
+			x = _mm_add_epi16(x, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+		}
+
+		JOGO_TARGET("avx2")
+		static __m256i Div255(__m256i x)
+		{
+			x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+		}
+
+		void BlendOver32Scalar(u32* Row, const u32* Source, size_t Count)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				u32 s = Source[i];
+				u32 d = Row[i];
+				u32 Inverse = 255 - (s >> 24);
+				u32 Result = 0;
+				for (u32 Shift = 0; Shift < 32; Shift += 8)
+				{
+					u32 Channel = ((s >> Shift) & 0xff) + Div255(((d >> Shift) & 0xff) * Inverse);
+					Result |= (Channel > 255 ? 255 : Channel) << Shift;
+				}
+				Row[i] = Result;
+			}
+		}
+
+		// two pixels' channels in 16 bits each: the destination scaled by 255 - the source alpha, the source added
+		static __m128i Over2(__m128i Source16, __m128i Dest16)
+		{
+			__m128i Alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(Source16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i Inverse = _mm_sub_epi16(_mm_set1_epi16(255), Alpha);
+			return _mm_add_epi16(Source16, Div255(_mm_mullo_epi16(Dest16, Inverse)));
+		}
+
+		void BlendOver32SSE2(u32* Row, const u32* Source, size_t Count)
+		{
+			__m128i Zero = _mm_setzero_si128();
+			size_t Blocks = Count / 4;
+			for (size_t i = 0; i < Blocks; i++, Row += 4, Source += 4)
+			{
+				__m128i s = _mm_loadu_si128((const __m128i*)Source);
+				__m128i d = _mm_loadu_si128((const __m128i*)Row);
+				__m128i Low = Over2(_mm_unpacklo_epi8(s, Zero), _mm_unpacklo_epi8(d, Zero));
+				__m128i High = Over2(_mm_unpackhi_epi8(s, Zero), _mm_unpackhi_epi8(d, Zero));
+				_mm_storeu_si128((__m128i*)Row, _mm_packus_epi16(Low, High));
+			}
+			BlendOver32Scalar(Row, Source, Count & 3);
+		}
+
+		JOGO_TARGET("avx2")
+		static __m256i Over4(__m256i Source16, __m256i Dest16)
+		{
+			__m256i Alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(Source16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i Inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), Alpha);
+			return _mm256_add_epi16(Source16, Div255(_mm256_mullo_epi16(Dest16, Inverse)));
+		}
+
+		JOGO_TARGET("avx2")
+		void BlendOver32AVX2(u32* Row, const u32* Source, size_t Count)
+		{
+			// the unpacks work within each 128 bit lane and the pack puts them back the same way
+			__m256i Zero = _mm256_setzero_si256();
+			size_t Blocks = Count / 8;
+			for (size_t i = 0; i < Blocks; i++, Row += 8, Source += 8)
+			{
+				__m256i s = _mm256_loadu_si256((const __m256i*)Source);
+				__m256i d = _mm256_loadu_si256((const __m256i*)Row);
+				__m256i Low = Over4(_mm256_unpacklo_epi8(s, Zero), _mm256_unpacklo_epi8(d, Zero));
+				__m256i High = Over4(_mm256_unpackhi_epi8(s, Zero), _mm256_unpackhi_epi8(d, Zero));
+				_mm256_storeu_si256((__m256i*)Row, _mm256_packus_epi16(Low, High));
+			}
+			_mm256_zeroupper();
+			BlendOver32Scalar(Row, Source, Count & 7);
+		}
+
+		void BlendAdd32Scalar(u32* Row, const u32* Source, size_t Count)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				u32 s = Source[i];
+				u32 d = Row[i];
+				u32 Result = 0;
+				for (u32 Shift = 0; Shift < 32; Shift += 8)
+				{
+					u32 Channel = ((s >> Shift) & 0xff) + ((d >> Shift) & 0xff);
+					Result |= (Channel > 255 ? 255 : Channel) << Shift;
+				}
+				Row[i] = Result;
+			}
+		}
+
+		void BlendAdd32SSE2(u32* Row, const u32* Source, size_t Count)
+		{
+			size_t Blocks = Count / 4;
+			for (size_t i = 0; i < Blocks; i++, Row += 4, Source += 4)
+			{
+				__m128i Sum = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)Source), _mm_loadu_si128((const __m128i*)Row));
+				_mm_storeu_si128((__m128i*)Row, Sum);
+			}
+			BlendAdd32Scalar(Row, Source, Count & 3);
+		}
+
+		JOGO_TARGET("avx2")
+		void BlendAdd32AVX2(u32* Row, const u32* Source, size_t Count)
+		{
+			size_t Blocks = Count / 8;
+			for (size_t i = 0; i < Blocks; i++, Row += 8, Source += 8)
+			{
+				__m256i Sum = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)Source), _mm256_loadu_si256((const __m256i*)Row));
+				_mm256_storeu_si256((__m256i*)Row, Sum);
+			}
+			_mm256_zeroupper();
+			BlendAdd32Scalar(Row, Source, Count & 7);
+		}
+
+		void ColorKey32Scalar(u32* Row, const u32* Source, size_t Count, u32 Key)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				if (Source[i] != Key)
+				{
+					Row[i] = Source[i];
+				}
+			}
+		}
+
+		void ColorKey32SSE2(u32* Row, const u32* Source, size_t Count, u32 Key)
+		{
+			__m128i Keys = _mm_set1_epi32((int)Key);
+			size_t Blocks = Count / 4;
+			for (size_t i = 0; i < Blocks; i++, Row += 4, Source += 4)
+			{
+				__m128i s = _mm_loadu_si128((const __m128i*)Source);
+				__m128i Keep = _mm_cmpeq_epi32(s, Keys);
+				__m128i d = _mm_loadu_si128((const __m128i*)Row);
+				_mm_storeu_si128((__m128i*)Row, _mm_or_si128(_mm_and_si128(Keep, d), _mm_andnot_si128(Keep, s)));
+			}
+			ColorKey32Scalar(Row, Source, Count & 3, Key);
+		}
+
+		JOGO_TARGET("avx2")
+		void ColorKey32AVX2(u32* Row, const u32* Source, size_t Count, u32 Key)
+		{
+			__m256i Keys = _mm256_set1_epi32((int)Key);
+			size_t Blocks = Count / 8;
+			for (size_t i = 0; i < Blocks; i++, Row += 8, Source += 8)
+			{
+				__m256i s = _mm256_loadu_si256((const __m256i*)Source);
+				__m256i d = _mm256_loadu_si256((const __m256i*)Row);
+				_mm256_storeu_si256((__m256i*)Row, _mm256_blendv_epi8(s, d, _mm256_cmpeq_epi32(s, Keys)));
+			}
+			_mm256_zeroupper();
+			ColorKey32Scalar(Row, Source, Count & 7, Key);
+		}
+
+		void BlendCoverage32Scalar(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				u32 a = Coverage[i];
+				u32 d = Row[i];
+				u32 Tint = (Color & 0xffffff) | 0xff000000;
+				u32 Inverse = Add ? 255 : 255 - a;
+				u32 Result = 0;
+				for (u32 Shift = 0; Shift < 32; Shift += 8)
+				{
+					u32 Channel = Div255(((Tint >> Shift) & 0xff) * a) + Div255(((d >> Shift) & 0xff) * Inverse);
+					Result |= (Channel > 255 ? 255 : Channel) << Shift;
+				}
+				Row[i] = Result;
+			}
+		}
+
+		void BlendCoverage32SSE2(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add)
+		{
+			// the tint is a constant, so only the coverage has to be spread across each pixel's four channels
+			__m128i Zero = _mm_setzero_si128();
+			__m128i Tint = _mm_unpacklo_epi8(_mm_set1_epi32((int)((Color & 0xffffff) | 0xff000000)), Zero);
+			__m128i Full = _mm_set1_epi16(255);
+			size_t Blocks = Count / 4;
+			for (size_t i = 0; i < Blocks; i++, Row += 4, Coverage += 4)
+			{
+				__m128i a = _mm_cvtsi32_si128(*(const int*)Coverage);
+				a = _mm_unpacklo_epi8(a, Zero);
+				a = _mm_unpacklo_epi16(a, a);
+				__m128i Alpha[2] = { _mm_unpacklo_epi32(a, a), _mm_unpackhi_epi32(a, a) };
+
+				__m128i d = _mm_loadu_si128((const __m128i*)Row);
+				__m128i Dest[2] = { _mm_unpacklo_epi8(d, Zero), _mm_unpackhi_epi8(d, Zero) };
+				for (u32 j = 0; j < 2; j++)
+				{
+					__m128i Inverse = Add ? Full : _mm_sub_epi16(Full, Alpha[j]);
+					Dest[j] = _mm_add_epi16(Div255(_mm_mullo_epi16(Tint, Alpha[j])), Div255(_mm_mullo_epi16(Dest[j], Inverse)));
+				}
+				_mm_storeu_si128((__m128i*)Row, _mm_packus_epi16(Dest[0], Dest[1]));
+			}
+			BlendCoverage32Scalar(Row, Coverage, Count & 3, Color, Add);
+		}
+
+		JOGO_TARGET("avx2")
+		void BlendCoverage32AVX2(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add)
+		{
+			// eight coverage bytes widened to a 16 bit copy per channel, pixels 0-1 and 4-5 in the low halves of the
+			// lanes to match how the destination unpacks
+			__m256i Zero = _mm256_setzero_si256();
+			__m256i Tint = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)((Color & 0xffffff) | 0xff000000)), Zero);
+			__m256i Full = _mm256_set1_epi16(255);
+			size_t Blocks = Count / 8;
+			for (size_t i = 0; i < Blocks; i++, Row += 8, Coverage += 8)
+			{
+				__m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)Coverage));
+				a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+				__m256i Alpha[2] = { _mm256_unpacklo_epi32(a, a), _mm256_unpackhi_epi32(a, a) };
+
+				__m256i d = _mm256_loadu_si256((const __m256i*)Row);
+				__m256i Dest[2] = { _mm256_unpacklo_epi8(d, Zero), _mm256_unpackhi_epi8(d, Zero) };
+				for (u32 j = 0; j < 2; j++)
+				{
+					__m256i Inverse = Add ? Full : _mm256_sub_epi16(Full, Alpha[j]);
+					Dest[j] = _mm256_add_epi16(Div255(_mm256_mullo_epi16(Tint, Alpha[j])), Div255(_mm256_mullo_epi16(Dest[j], Inverse)));
+				}
+				_mm256_storeu_si256((__m256i*)Row, _mm256_packus_epi16(Dest[0], Dest[1]));
+			}
+			_mm256_zeroupper();
+			BlendCoverage32Scalar(Row, Coverage, Count & 7, Color, Add);
+		}
+
+		void BlendOver32(u32* Row, const u32* Source, size_t Count)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				BlendOver32AVX2(Row, Source, Count);
+				break;
+			case LEVEL_SSE2:
+				BlendOver32SSE2(Row, Source, Count);
+				break;
+			default:
+				BlendOver32Scalar(Row, Source, Count);
+				break;
+			}
+		}
+
+		void BlendAdd32(u32* Row, const u32* Source, size_t Count)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				BlendAdd32AVX2(Row, Source, Count);
+				break;
+			case LEVEL_SSE2:
+				BlendAdd32SSE2(Row, Source, Count);
+				break;
+			default:
+				BlendAdd32Scalar(Row, Source, Count);
+				break;
+			}
+		}
+
+		void ColorKey32(u32* Row, const u32* Source, size_t Count, u32 Key)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				ColorKey32AVX2(Row, Source, Count, Key);
+				break;
+			case LEVEL_SSE2:
+				ColorKey32SSE2(Row, Source, Count, Key);
+				break;
+			default:
+				ColorKey32Scalar(Row, Source, Count, Key);
+				break;
+			}
+		}
+
+		void BlendCoverage32(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				BlendCoverage32AVX2(Row, Coverage, Count, Color, Add);
+				break;
+			case LEVEL_SSE2:
+				BlendCoverage32SSE2(Row, Coverage, Count, Color, Add);
+				break;
+			default:
+				BlendCoverage32Scalar(Row, Coverage, Count, Color, Add);
+				break;
+			}
+		}
+
+		void ReplicateRow32Scalar(u32* Row, const u32* Source, size_t Count, u32 Factor)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				for (u32 j = 0; j < Factor; j++)
+				{
+					*Row++ = Source[i];
+				}
+			}
+		}
+
+		void ReplicateRow32SSE2(u32* Row, const u32* Source, size_t Count, u32 Factor)
+		{
+			// four source pixels make Factor stores, each a shuffle of them
+			size_t Blocks = Count / 4;
+			__m128i* Dest = (__m128i*)Row;
+			for (size_t i = 0; i < Blocks; i++, Source += 4)
+			{
+				__m128i Pixels = _mm_loadu_si128((const __m128i*)Source);
+				switch (Factor)
+				{
+				case 2:
+					_mm_storeu_si128(Dest++, _mm_unpacklo_epi32(Pixels, Pixels));
+					_mm_storeu_si128(Dest++, _mm_unpackhi_epi32(Pixels, Pixels));
+					break;
+				case 3:
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(1, 0, 0, 0)));
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(2, 2, 1, 1)));
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(3, 3, 3, 2)));
+					break;
+				default:
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(0, 0, 0, 0)));
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(1, 1, 1, 1)));
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(2, 2, 2, 2)));
+					_mm_storeu_si128(Dest++, _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(3, 3, 3, 3)));
+					break;
+				}
+			}
+			ReplicateRow32Scalar((u32*)Dest, Source, Count & 3, Factor);
+		}
+
+		JOGO_TARGET("avx2")
+		void ReplicateRow32AVX2(u32* Row, const u32* Source, size_t Count, u32 Factor)
+		{
+			// eight source pixels make Factor stores, each a permute of them
+			__m256i Permutes[MaxReplicate];
+			for (u32 p = 0; p < Factor; p++)
+			{
+				u32 Lanes[8];
+				for (u32 e = 0; e < 8; e++)
+				{
+					Lanes[e] = (p * 8 + e) / Factor;
+				}
+				Permutes[p] = _mm256_loadu_si256((const __m256i*)Lanes);
+			}
+
+			size_t Blocks = Count / 8;
+			__m256i* Dest = (__m256i*)Row;
+			for (size_t i = 0; i < Blocks; i++, Source += 8)
+			{
+				__m256i Pixels = _mm256_loadu_si256((const __m256i*)Source);
+				for (u32 p = 0; p < Factor; p++)
+				{
+					_mm256_storeu_si256(Dest++, _mm256_permutevar8x32_epi32(Pixels, Permutes[p]));
+				}
+			}
+			_mm256_zeroupper();
+			ReplicateRow32Scalar((u32*)Dest, Source, Count & 7, Factor);
+		}
+
+		void ReplicateRow32(u32* Row, const u32* Source, size_t Count, u32 Factor)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				ReplicateRow32AVX2(Row, Source, Count, Factor);
+				break;
+			case LEVEL_SSE2:
+				ReplicateRow32SSE2(Row, Source, Count, Factor);
+				break;
+			default:
+				ReplicateRow32Scalar(Row, Source, Count, Factor);
+				break;
+			}
+		}
+
+		void FillRow32(u32* Row, u32 Color, size_t Count, bool Stream)
+		{
+			switch (CurrentLevel)
+			{
+			case LEVEL_AVX2:
+				FillRow32AVX2(Row, Color, Count, Stream);
+				break;
+			case LEVEL_SSE2:
+				FillRow32SSE2(Row, Color, Count, Stream);
+				break;
+			default:
+				FillRow32Scalar(Row, Color, Count, Stream);
+				break;
+			}
+		}
+
+		void Expand24To32Scalar(u32* Row, const u8* Source, size_t Count)
+		{
+			for (size_t i = 0; i < Count; i++, Source += 3)
+			{
+				Row[i] = 0xff000000 | (Source[2] << 16) | (Source[1] << 8) | Source[0];
+			}
+		}
+
+		JOGO_TARGET("ssse3")
+		void Expand24To32SSSE3(u32* Row, const u8* Source, size_t Count)
+		{
+			// each 16 byte load takes 4 pixels from its first 12, so stop while 16 are still there to read
+			__m128i Spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			__m128i Alpha = _mm_set1_epi32((int)0xff000000);
+			size_t i = 0;
+			for (; i + 6 <= Count; i += 4, Source += 12)
+			{
+				__m128i Pixels = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)Source), Spread);
+				_mm_storeu_si128((__m128i*)(Row + i), _mm_or_si128(Pixels, Alpha));
+			}
+			Expand24To32Scalar(Row + i, Source, Count - i);
+		}
+
+		void Expand24To32(u32* Row, const u8* Source, size_t Count)
+		{
+			if (CurrentLevel >= LEVEL_SSE2 && GetCPUFeatures().SSSE3)
+			{
+				Expand24To32SSSE3(Row, Source, Count);
+			}
+			else
+			{
+				Expand24To32Scalar(Row, Source, Count);
+			}
+		}
+	};
+};
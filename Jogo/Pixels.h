@@ -0,0 +1,84 @@
+#pragma once
+#include "int_types.h"
+#include "Platform.h"
+
+namespace Jogo
+{
+	// the row kernels under Bitmap's primitives, scalar, SSE2 and AVX2 versions of each
+	// the plain entry points pick by GetLevel, the suffixed ones are there to benchmark against each other
+	namespace Pixels
+	{
+		enum Level : u32
+		{
+			LEVEL_SCALAR,
+			LEVEL_SSE2,
+			LEVEL_AVX2,
+		};
+
+		// the widest the CPU has, or JOGO_SIMD=scalar/sse2/avx2 to turn it down; SetLevel can't go above the CPU
+		Level GetLevel();
+		void SetLevel(Level NewLevel);
+
+		// a fill bigger than this goes around the cache with non-temporal stores, since it would only
+		// evict everything else on its way through; it's above a 1024x1024 backbuffer because an Erase
+		// of that is read straight back by the frame's drawing, and streaming only pulled ahead past it
+		static const size_t StreamThreshold = 8 * 1024 * 1024;
+
+		// Stream uses non-temporal stores, call EndStream after the last streamed row before reading it back
+		void FillRow32(u32* Row, u32 Color, size_t Count, bool Stream = false);
+		void FillRow32Scalar(u32* Row, u32 Color, size_t Count, bool Stream = false);
+		void FillRow32SSE2(u32* Row, u32 Color, size_t Count, bool Stream = false);
+		void FillRow32AVX2(u32* Row, u32 Color, size_t Count, bool Stream = false);
+		void EndStream();
+
+		// an 8bpp mask row to 32bpp, Color where the mask isn't 0 and BkColor where it is, or the pixel left alone if !Opaque
+		void ExpandMask32(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque);
+		void ExpandMask32Scalar(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque);
+		void ExpandMask32SSE2(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque);
+		void ExpandMask32AVX2(u32* Row, const u8* Mask, size_t Count, u32 Color, u32 BkColor, bool Opaque);
+
+		// Count pixels sampled from Source at x, x + dx, x + 2dx... in 16.16, none of them past the end of Source's row
+		// SSE2 has no gather, so below AVX2 this is the scalar loop
+		void ScaleRow32(u32* Row, const u32* Source, size_t Count, u32 x, u32 dx);
+		void ScaleRow32Scalar(u32* Row, const u32* Source, size_t Count, u32 x, u32 dx);
+		void ScaleRow32AVX2(u32* Row, const u32* Source, size_t Count, u32 x, u32 dx);
+
+		// premultiplied alpha, Row = Source + Row * (255 - Source alpha) / 255 per channel, rounded
+		void BlendOver32(u32* Row, const u32* Source, size_t Count);
+		void BlendOver32Scalar(u32* Row, const u32* Source, size_t Count);
+		void BlendOver32SSE2(u32* Row, const u32* Source, size_t Count);
+		void BlendOver32AVX2(u32* Row, const u32* Source, size_t Count);
+
+		// per channel, saturating
+		void BlendAdd32(u32* Row, const u32* Source, size_t Count);
+		void BlendAdd32Scalar(u32* Row, const u32* Source, size_t Count);
+		void BlendAdd32SSE2(u32* Row, const u32* Source, size_t Count);
+		void BlendAdd32AVX2(u32* Row, const u32* Source, size_t Count);
+
+		// Source copied over Row except where it's exactly Key
+		void ColorKey32(u32* Row, const u32* Source, size_t Count, u32 Key);
+		void ColorKey32Scalar(u32* Row, const u32* Source, size_t Count, u32 Key);
+		void ColorKey32SSE2(u32* Row, const u32* Source, size_t Count, u32 Key);
+		void ColorKey32AVX2(u32* Row, const u32* Source, size_t Count, u32 Key);
+
+		// 8bpp coverage tinted by Color's rgb: each pixel is Color premultiplied by its coverage, with the coverage as
+		// its alpha, blended over Row or added to it
+		void BlendCoverage32(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add);
+		void BlendCoverage32Scalar(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add);
+		void BlendCoverage32SSE2(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add);
+		void BlendCoverage32AVX2(u32* Row, const u8* Coverage, size_t Count, u32 Color, bool Add);
+
+		// each of Count Source pixels written Factor times over, Factor 2 to MaxReplicate
+		static const u32 MaxReplicate = 4;
+		void ReplicateRow32(u32* Row, const u32* Source, size_t Count, u32 Factor);
+		void ReplicateRow32Scalar(u32* Row, const u32* Source, size_t Count, u32 Factor);
+		void ReplicateRow32SSE2(u32* Row, const u32* Source, size_t Count, u32 Factor);
+		void ReplicateRow32AVX2(u32* Row, const u32* Source, size_t Count, u32 Factor);
+
+		// packed 24bpp BGR to BGRA with alpha 255, as a BMP row is stored
+		// SSSE3 isn't a level of its own, the shuffle version runs from SSE2 up when the CPU has it
+		void Expand24To32(u32* Row, const u8* Source, size_t Count);
+		void Expand24To32Scalar(u32* Row, const u8* Source, size_t Count);
+		void Expand24To32SSSE3(u32* Row, const u8* Source, size_t Count);
+	};
+};
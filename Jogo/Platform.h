@@ -0,0 +1,231 @@
+#pragma once
+#include "int_types.h"
+
+// compiler portability for the MSVC intrinsics and CRT calls used throughout Jogo
+#if defined(_MSC_VER)
+
+#include <intrin.h>
+
+#else
+
+#include <x86intrin.h>
+#include <cpuid.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <alloca.h>
+#include <string.h>
+#include <sys/stat.h>
+
+inline void __stosb(unsigned char* Dest, unsigned char Data, size_t Count)
+{
+	__asm__ __volatile__("rep stosb" : "+D"(Dest), "+c"(Count) : "a"(Data) : "memory");
+}
+
+// MSVC's unsigned long is 32 bits, so this always stores dwords regardless of the LP64 type
+inline void __stosd(unsigned long* Dest, unsigned long Data, size_t Count)
+{
+	__asm__ __volatile__("rep stosl" : "+D"(Dest), "+c"(Count) : "a"((u32)Data) : "memory");
+}
+
+inline void __movsb(unsigned char* Dest, const unsigned char* Source, size_t Count)
+{
+	__asm__ __volatile__("rep movsb" : "+D"(Dest), "+S"(Source), "+c"(Count) : : "memory");
+}
+
+// like MSVC's, only the low 32 bits of Mask are looked at
+inline unsigned char _BitScanReverse(unsigned long* Index, unsigned long Mask)
+{
+	if (!(u32)Mask)
+		return 0;
+	*Index = 31 - __builtin_clz((u32)Mask);
+	return 1;
+}
+
+inline void __debugbreak()
+{
+	__asm__ __volatile__("int3");
+}
+
+inline int fopen_s(FILE** File, const char* Filename, const char* Mode)
+{
+	*File = fopen(Filename, Mode);
+	return *File ? 0 : 1;
+}
+
+inline int strcpy_s(char* Dest, size_t DestSize, const char* Source)
+{
+	snprintf(Dest, DestSize, "%s", Source);
+	return 0;
+}
+
+inline int strcat_s(char* Dest, size_t DestSize, const char* Source)
+{
+	size_t Length = strnlen(Dest, DestSize);
+	snprintf(Dest + Length, DestSize - Length, "%s", Source);
+	return 0;
+}
+
+inline long _filelength(int FileHandle)
+{
+	struct stat Stat;
+	return fstat(FileHandle, &Stat) ? -1 : (long)Stat.st_size;
+}
+
+#define _fileno fileno
+#define _alloca alloca
+#define sprintf_s snprintf
+
+#endif
+
+// GCC and Clang only emit instructions past the baseline inside functions marked for them, MSVC always does
+// mark a kernel JOGO_TARGET("avx2") and only call it when GetCPUFeatures says so
+#if defined(_MSC_VER)
+#define JOGO_TARGET(Features)
+#else
+#define JOGO_TARGET(Features) __attribute__((target(Features)))
+#endif
+
+namespace Jogo
+{
+	// atomics, all are full barriers which is what the locked x86 instructions give us anyway
+#if defined(_MSC_VER)
+	inline s32 AtomicAdd(volatile s32* Value, s32 Addend)
+	{
+		return (s32)_InterlockedExchangeAdd((volatile long*)Value, Addend) + Addend;
+	}
+
+	inline s64 AtomicAdd64(volatile s64* Value, s64 Addend)
+	{
+		return _InterlockedExchangeAdd64(Value, Addend) + Addend;
+	}
+
+	inline bool AtomicCompareExchange64(volatile s64* Value, s64 Expected, s64 Desired)
+	{
+		return _InterlockedCompareExchange64(Value, Desired, Expected) == Expected;
+	}
+
+	inline void AtomicFence()
+	{
+		_mm_mfence();
+	}
+
+	inline void CompilerBarrier()
+	{
+		_ReadWriteBarrier();
+	}
+#else
+	inline s32 AtomicAdd(volatile s32* Value, s32 Addend)
+	{
+		return __atomic_add_fetch(Value, Addend, __ATOMIC_SEQ_CST);
+	}
+
+	inline s64 AtomicAdd64(volatile s64* Value, s64 Addend)
+	{
+		return __atomic_add_fetch(Value, Addend, __ATOMIC_SEQ_CST);
+	}
+
+	inline bool AtomicCompareExchange64(volatile s64* Value, s64 Expected, s64 Desired)
+	{
+		return __atomic_compare_exchange_n(Value, &Expected, Desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	}
+
+	inline void AtomicFence()
+	{
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+
+	inline void CompilerBarrier()
+	{
+		__asm__ __volatile__("" : : : "memory");
+	}
+#endif
+
+	inline void SpinPause()
+	{
+		_mm_pause();
+	}
+
+	// SSE2 is always there on x64
+	struct CPUFeatures
+	{
+		bool SSSE3;
+		bool SSE41;
+		bool AVX2;
+	};
+
+	inline void Cpuid(u32 Info[4], u32 Leaf, u32 SubLeaf)
+	{
+#if defined(_MSC_VER)
+		__cpuidex((int*)Info, (int)Leaf, (int)SubLeaf);
+#else
+		__cpuid_count(Leaf, SubLeaf, Info[0], Info[1], Info[2], Info[3]);
+#endif
+	}
+
+	inline CPUFeatures DetectCPUFeatures()
+	{
+		CPUFeatures Features = {};
+		u32 Info[4];
+		Cpuid(Info, 1, 0);
+		Features.SSSE3 = (Info[2] & (1 << 9)) != 0;
+		Features.SSE41 = (Info[2] & (1 << 19)) != 0;
+
+		// AVX needs the OS to save the upper halves of the registers too
+		bool OSSavesYMM = false;
+		if ((Info[2] & (1 << 27)) && (Info[2] & (1 << 28)))
+		{
+#if defined(_MSC_VER)
+			u64 XCR0 = _xgetbv(0);
+#else
+			u32 Low, High;
+			__asm__ __volatile__("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+			u64 XCR0 = ((u64)High << 32) | Low;
+#endif
+			OSSavesYMM = (XCR0 & 6) == 6;
+		}
+		if (OSSavesYMM)
+		{
+			Cpuid(Info, 7, 0);
+			Features.AVX2 = (Info[1] & (1 << 5)) != 0;
+		}
+		return Features;
+	}
+
+	inline const CPUFeatures& GetCPUFeatures()
+	{
+		static CPUFeatures Features = DetectCPUFeatures();
+		return Features;
+	}
+
+	// a whole file mapped copy on write: writes through Data change this process's pages, never the file
+	// pages are read in from the file as they're first touched, so mapping costs the same for any size
+	struct MappedFile
+	{
+		u8* Data;
+		size_t Size;
+	};
+
+	// false for a missing or empty file, the platform backends implement these
+	bool MapFile(const char* Filename, MappedFile& File);
+	void UnmapFile(MappedFile& File);
+
+	// for short critical sections only, waiters spin rather than sleep
+	struct SpinLock
+	{
+		volatile s64 Locked;
+
+		void Lock()
+		{
+			while (Locked || !AtomicCompareExchange64(&Locked, 0, 1))
+			{
+				SpinPause();
+			}
+		}
+
+		void Unlock()
+		{
+			CompilerBarrier();
+			Locked = 0;
+		}
+	};
+};
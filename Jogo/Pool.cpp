@@ -0,0 +1,263 @@
+#include "Jogo.h"
+#include "Pool.h"
+
+namespace Jogo
+{
+	// blocks move between a thread cache and the shared lists this many at a time
+	static const u32 CacheBatch = 16;
+
+	struct ThreadCache
+	{
+		u32 Generation;		// of the allocator whose blocks these are, anything else is stale
+		u32 Count[FreeListAllocator::NumClasses];
+		FreeListAllocator::FreeBlock* Lists[FreeListAllocator::NumClasses];
+
+		// counted here and added to the allocator's stats whenever the cache takes its lock
+		s64 Allocs[FreeListAllocator::NumClasses];
+		s64 Frees[FreeListAllocator::NumClasses];
+	};
+
+	thread_local ThreadCache ThreadCaches[FreeListAllocator::MaxThreadCaches];
+	SpinLock CacheSlotLock;
+	u32 CacheSlotsInUse = 0;
+	volatile s32 NextGeneration = 0;
+
+	u32 FreeListAllocator::GetSizeClass(size_t Size)
+	{
+		if (Size <= 16)
+			return 0;
+
+		// two classes per power of 2, the first one and a half times it
+		size_t Last = Size - 1;
+		unsigned long Bit;
+		_BitScanReverse(&Bit, (unsigned long)Last);
+		return (u32)(Bit - 4) * 2 + (u32)((Last >> (Bit - 1)) & 1) + 1;
+	}
+
+	size_t FreeListAllocator::GetClassSize(u32 SizeClass)
+	{
+		if (!SizeClass)
+			return 16;
+
+		u32 Bit = (SizeClass - 1) / 2 + 4;
+		return (size_t)(3 + ((SizeClass - 1) & 1)) << (Bit - 1);
+	}
+
+	FreeListAllocator FreeListAllocator::Create(Arena& Memory, bool ThreadCache)
+	{
+		FreeListAllocator NewAllocator = {};
+		NewAllocator.Memory = &Memory;
+		NewAllocator.Generation = (u32)AtomicAdd(&NextGeneration, 1);
+		for (u32 c = 0; c < NumClasses; c++)
+		{
+			NewAllocator.Stats[c].BlockSize = GetClassSize(c);
+		}
+
+		NewAllocator.CacheSlot = MaxThreadCaches;
+		if (ThreadCache)
+		{
+			CacheSlotLock.Lock();
+			for (u32 i = 0; i < MaxThreadCaches; i++)
+			{
+				if (!(CacheSlotsInUse & (1 << i)))
+				{
+					CacheSlotsInUse |= 1 << i;
+					NewAllocator.CacheSlot = i;
+					break;
+				}
+			}
+			CacheSlotLock.Unlock();
+		}
+		return NewAllocator;
+	}
+
+	// call with the lock held
+	static bool CarveBlocks(FreeListAllocator& Allocator, u32 SizeClass)
+	{
+		size_t BlockSize = FreeListAllocator::GetClassSize(SizeClass);
+		u32 Count = (u32)max(FreeListAllocator::CarveBytes / BlockSize, (size_t)1);
+		u8* Run = (u8*)Allocator.Memory->Allocate(BlockSize * Count);
+		if (!Run)
+			return false;
+
+		for (u32 i = Count; i-- > 0;)
+		{
+			FreeListAllocator::FreeBlock* Block = (FreeListAllocator::FreeBlock*)(Run + i * BlockSize);
+			Block->Next = Allocator.FreeLists[SizeClass];
+			Allocator.FreeLists[SizeClass] = Block;
+		}
+		Allocator.Stats[SizeClass].Carved += Count;
+		return true;
+	}
+
+	static void CountBlocks(PoolStats& Stats, s64 Allocs, s64 Frees)
+	{
+		Stats.Allocs += Allocs;
+		Stats.Frees += Frees;
+
+		// one thread's frees of another's blocks can be counted before its allocations are
+		s64 Live = (s64)(Stats.Allocs - Stats.Frees);
+		Stats.Live = Live > 0 ? (u32)Live : 0;
+		Stats.Peak = max(Stats.Peak, Stats.Live);
+	}
+
+	static ThreadCache* GetCache(FreeListAllocator& Allocator)
+	{
+		if (Allocator.CacheSlot >= FreeListAllocator::MaxThreadCaches)
+			return nullptr;
+
+		ThreadCache& Cache = ThreadCaches[Allocator.CacheSlot];
+		if (Cache.Generation != Allocator.Generation)
+		{
+			Cache = {};
+			Cache.Generation = Allocator.Generation;
+		}
+		return &Cache;
+	}
+
+	// call with the lock held
+	static void MergeCacheStats(FreeListAllocator& Allocator, ThreadCache& Cache, u32 SizeClass)
+	{
+		CountBlocks(Allocator.Stats[SizeClass], Cache.Allocs[SizeClass], Cache.Frees[SizeClass]);
+		Cache.Allocs[SizeClass] = 0;
+		Cache.Frees[SizeClass] = 0;
+	}
+
+	void* FreeListAllocator::Allocate(size_t Size)
+	{
+		if (Size > MaxSize)
+			return nullptr;
+
+		u32 c = GetSizeClass(Size);
+		ThreadCache* Cache = GetCache(*this);
+		if (Cache)
+		{
+			if (!Cache->Lists[c])
+			{
+				Lock.Lock();
+				MergeCacheStats(*this, *Cache, c);
+				for (u32 i = 0; i < CacheBatch && (FreeLists[c] || CarveBlocks(*this, c)); i++)
+				{
+					FreeBlock* Block = FreeLists[c];
+					FreeLists[c] = Block->Next;
+					Block->Next = Cache->Lists[c];
+					Cache->Lists[c] = Block;
+					Cache->Count[c]++;
+				}
+				Lock.Unlock();
+				if (!Cache->Lists[c])
+					return nullptr;
+			}
+
+			FreeBlock* Result = Cache->Lists[c];
+			Cache->Lists[c] = Result->Next;
+			Cache->Count[c]--;
+			Cache->Allocs[c]++;
+			return Result;
+		}
+
+		Lock.Lock();
+		FreeBlock* Result = nullptr;
+		if (FreeLists[c] || CarveBlocks(*this, c))
+		{
+			Result = FreeLists[c];
+			FreeLists[c] = Result->Next;
+			CountBlocks(Stats[c], 1, 0);
+		}
+		Lock.Unlock();
+		return Result;
+	}
+
+	void FreeListAllocator::Free(void* Block, size_t Size)
+	{
+		if (!Block || Size > MaxSize)
+			return;
+
+		u32 c = GetSizeClass(Size);
+		FreeBlock* Freed = (FreeBlock*)Block;
+		ThreadCache* Cache = GetCache(*this);
+		if (Cache)
+		{
+			Freed->Next = Cache->Lists[c];
+			Cache->Lists[c] = Freed;
+			Cache->Frees[c]++;
+
+			// keep one batch in hand so alternating Allocate and Free doesn't bounce on the lock
+			if (++Cache->Count[c] >= CacheBatch * 2)
+			{
+				Lock.Lock();
+				MergeCacheStats(*this, *Cache, c);
+				for (u32 i = 0; i < CacheBatch; i++)
+				{
+					FreeBlock* Returned = Cache->Lists[c];
+					Cache->Lists[c] = Returned->Next;
+					Returned->Next = FreeLists[c];
+					FreeLists[c] = Returned;
+				}
+				Cache->Count[c] -= CacheBatch;
+				Lock.Unlock();
+			}
+			return;
+		}
+
+		Lock.Lock();
+		Freed->Next = FreeLists[c];
+		FreeLists[c] = Freed;
+		CountBlocks(Stats[c], 0, 1);
+		Lock.Unlock();
+	}
+
+	void FreeListAllocator::FlushThreadCache()
+	{
+		ThreadCache* Cache = GetCache(*this);
+		if (!Cache)
+			return;
+
+		Lock.Lock();
+		for (u32 c = 0; c < NumClasses; c++)
+		{
+			MergeCacheStats(*this, *Cache, c);
+			while (FreeBlock* Returned = Cache->Lists[c])
+			{
+				Cache->Lists[c] = Returned->Next;
+				Returned->Next = FreeLists[c];
+				FreeLists[c] = Returned;
+			}
+			Cache->Count[c] = 0;
+		}
+		Lock.Unlock();
+	}
+
+	void FreeListAllocator::Reset()
+	{
+		Lock.Lock();
+		for (u32 c = 0; c < NumClasses; c++)
+		{
+			FreeLists[c] = nullptr;
+			Stats[c] = {};
+			Stats[c].BlockSize = GetClassSize(c);
+		}
+		Generation = (u32)AtomicAdd(&NextGeneration, 1);
+		Lock.Unlock();
+	}
+
+	void FreeListAllocator::Release()
+	{
+		Reset();
+		if (CacheSlot < MaxThreadCaches)
+		{
+			CacheSlotLock.Lock();
+			CacheSlotsInUse &= ~(1 << CacheSlot);
+			CacheSlotLock.Unlock();
+			CacheSlot = MaxThreadCaches;
+		}
+	}
+
+	PoolStats FreeListAllocator::GetStats(u32 SizeClass)
+	{
+		Lock.Lock();
+		PoolStats Result = Stats[SizeClass < NumClasses ? SizeClass : NumClasses - 1];
+		Lock.Unlock();
+		return Result;
+	}
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include "int_types.h"
+#include "Platform.h"
+#include "Arena.h"
+
+namespace Jogo
+{
+	struct PoolStats
+	{
+		size_t BlockSize;
+		u32 Carved;		// blocks ever taken from the arena
+		u32 Live;		// handed out and not yet freed
+		u32 Peak;		// most Live at once
+		u64 Allocs;
+		u64 Frees;
+	};
+
+	// blocks for one type, carved from an Arena BlocksPerCarve at a time
+	// freed blocks go on a list and are handed out again before the arena is touched, so a pool that churns
+	// stays the size of its peak, not the number of allocations
+	// the memory lives as long as the arena, and Allocate returns it uninitialised like Arena does
+	// not thread safe, give each thread its own or use a FreeListAllocator with a thread cache
+	template<typename T>
+	struct Pool
+	{
+		union Block
+		{
+			Block* Next;
+			alignas(T) u8 Storage[sizeof(T)];
+		};
+
+		Arena* Memory;
+		Block* FreeList;
+		Block* Carve;		// the rest of the last run taken from the arena
+		Block* CarveEnd;
+		u32 BlocksPerCarve;
+		PoolStats Stats;
+
+		static Pool Create(Arena& Memory, u32 BlocksPerCarve = 64)
+		{
+			Pool NewPool = {};
+			NewPool.Memory = &Memory;
+			NewPool.BlocksPerCarve = BlocksPerCarve ? BlocksPerCarve : 1;
+			NewPool.Stats.BlockSize = sizeof(Block);
+			return NewPool;
+		}
+
+		T* Allocate()
+		{
+			Block* Result = FreeList;
+			if (Result)
+			{
+				FreeList = Result->Next;
+			}
+			else
+			{
+				if (Carve == CarveEnd)
+				{
+					// over-allocate by one block so the run can be aligned for T whatever the arena's alignment
+					u8* Run = (u8*)Memory->Allocate(sizeof(Block) * (BlocksPerCarve + 1));
+					if (!Run)
+						return nullptr;
+					Carve = (Block*)(((size_t)Run + alignof(Block) - 1) & ~(alignof(Block) - 1));
+					CarveEnd = Carve + BlocksPerCarve;
+				}
+				Result = Carve++;
+				Stats.Carved++;
+			}
+			Stats.Allocs++;
+			if (++Stats.Live > Stats.Peak)
+			{
+				Stats.Peak = Stats.Live;
+			}
+			return (T*)Result->Storage;
+		}
+
+		void Free(T* Object)
+		{
+			if (!Object)
+				return;
+
+			Block* Freed = (Block*)Object;
+			Freed->Next = FreeList;
+			FreeList = Freed;
+			Stats.Frees++;
+			Stats.Live--;
+		}
+
+		// forget every block, for when the arena has just been cleared
+		void Reset()
+		{
+			FreeList = nullptr;
+			Carve = CarveEnd = nullptr;
+			Stats.Live = 0;
+			Stats.Carved = 0;
+		}
+	};
+
+	// free lists for a spread of block sizes, 16 bytes to MaxSize in steps of half a power of 2, carved from an Arena
+	// Free takes the size that was allocated, so blocks carry no header
+	// with ThreadCache set each thread keeps a short list per size and only takes the lock to move a batch at a time,
+	// otherwise every call takes the lock. Either way it is safe to call from any thread, but the arena must not be
+	// used by anyone else
+	struct FreeListAllocator
+	{
+		static const u32 NumClasses = 17;
+		static const size_t MaxSize = 4096;
+		static const u32 MaxThreadCaches = 4;
+
+		// bigger sizes carve fewer blocks at once
+		static const size_t CarveBytes = 16 * 1024;
+
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		Arena* Memory;
+		SpinLock Lock;
+		FreeBlock* FreeLists[NumClasses];
+		PoolStats Stats[NumClasses];
+		u32 CacheSlot;		// MaxThreadCaches when not caching
+		u32 Generation;
+
+		static FreeListAllocator Create(Arena& Memory, bool ThreadCache = false);
+
+		// Size = 0 gets the smallest block, more than MaxSize gets nullptr
+		void* Allocate(size_t Size);
+		void Free(void* Block, size_t Size);
+
+		// puts this thread's cached blocks back on the shared lists, call it before a thread exits
+		void FlushThreadCache();
+
+		// forget every block, for when the arena has just been cleared; other threads' caches are dropped
+		// the next time they are used
+		void Reset();
+		void Release();
+
+		PoolStats GetStats(u32 SizeClass);
+		static u32 GetSizeClass(size_t Size);
+		static size_t GetClassSize(u32 SizeClass);
+	};
+};
@@ -0,0 +1,557 @@
+#include "Jogo.h"
+#include "Profiler.h"
+#include <stdio.h>
+
+namespace Jogo
+{
+	namespace Profiler
+	{
+		enum EventType : u32
+		{
+			EventBegin,
+			EventEnd,		// closes the innermost open zone
+			EventCounter,
+		};
+
+		struct Event
+		{
+			u64 Time;
+			const char* Name;
+			f32 Value;
+			EventType Type;
+		};
+
+		struct OpenZone
+		{
+			const char* Name;
+			u64 Start;
+			s32 Node;
+		};
+
+		static const u32 LogSize = 1 << 16;	// power of 2
+		static const u32 MaxDepth = 32;
+		static const u32 MaxThreads = 64;
+
+		// each thread writes only its own log, EndFrame on the main thread is the only reader
+		struct ThreadLog
+		{
+			Event Events[LogSize];
+			volatile u64 Write;
+			u64 Read;
+			u32 Index;
+			u32 Depth;
+			OpenZone Stack[MaxDepth];
+		};
+
+		ThreadLog* volatile Logs[MaxThreads];
+		volatile s32 NumLogs = 0;
+		thread_local ThreadLog* LocalLog = nullptr;
+
+		FrameSummary Summaries[2];
+		u32 CurrentSummary = 0;
+		u32 FrameNumber = 0;
+		u64 FrameStart = 0;
+		double TicksPerSecond = 0;
+		u64 CalibrationTicks = 0;
+		Timer CalibrationTimer;
+
+		static ThreadLog* GetLog()
+		{
+			if (!LocalLog)
+			{
+				s32 Index = AtomicAdd(&NumLogs, 1) - 1;
+				if (Index >= (s32)MaxThreads)
+					return nullptr;
+
+				ThreadLog* Log = (ThreadLog*)Allocate(sizeof(ThreadLog));
+				if (!Log)
+					return nullptr;
+				Log->Index = Index;
+				Logs[Index] = Log;
+				LocalLog = Log;
+			}
+			return LocalLog;
+		}
+
+		static void Record(EventType Type, const char* Name, f32 Value)
+		{
+			ThreadLog* Log = GetLog();
+			if (Log)
+			{
+				u64 w = Log->Write;
+				Log->Events[w & (LogSize - 1)] = { __rdtsc(), Name, Value, Type };
+				CompilerBarrier();
+				Log->Write = w + 1;
+			}
+		}
+
+		void BeginZone(const char* Name)
+		{
+			Record(EventBegin, Name, 0);
+		}
+
+		void EndZone()
+		{
+			Record(EventEnd, nullptr, 0);
+		}
+
+		void RecordCounter(const char* Name, float Value)
+		{
+			Record(EventCounter, Name, Value);
+		}
+
+		enum CaptureType : u32
+		{
+			CaptureZone,
+			CaptureCounter,
+			CaptureFrame,
+		};
+
+		struct CaptureEvent
+		{
+			u64 Start;
+			u64 Ticks;
+			const char* Name;
+			f32 Value;
+			CaptureType Type;
+			u32 Thread;
+			u32 Frame;
+		};
+
+		// EndFrame appends to Buffers[Front] while the writer thread turns the other one into JSON
+		struct Capture
+		{
+			Arena Buffers[2];
+			u32 Front;
+			Arena* volatile Pending;
+			volatile double PendingTicksPerSecond;
+			volatile s32 Busy;
+			volatile s32 Stopping;
+			Semaphore WakeUp;
+			Thread Writer;
+
+			FILE* File;
+			Arena Text;
+			bool FirstEvent;
+			u64 NamedThreads;
+
+			bool Active;
+			u32 FramesLeft;
+			u64 StartTicks;
+			Timer ElapsedTimer;
+			double ElapsedSeconds;
+			u32 MainThread;
+			u32 NumEvents;
+			u32 Dropped;
+		};
+
+		static const size_t CaptureBufferSize = 8 * 1024 * 1024;
+		static const size_t CaptureTextSize = 1024 * 1024;
+		Capture TraceCapture;
+
+		static void AddCaptureEvent(const CaptureEvent& NewEvent)
+		{
+			CaptureEvent* e = (CaptureEvent*)TraceCapture.Buffers[TraceCapture.Front].Allocate(sizeof(CaptureEvent));
+			if (e)
+			{
+				*e = NewEvent;
+				TraceCapture.NumEvents++;
+			}
+			else
+			{
+				TraceCapture.Dropped++;
+			}
+		}
+
+		static bool SameName(const char* a, const char* b)
+		{
+			if (a == b)
+				return true;
+			while (*a && *a == *b)
+			{
+				a++;
+				b++;
+			}
+			return *a == *b;
+		}
+
+		static s32 FindNode(FrameSummary& Frame, s32 Parent, const char* Name, u32 Depth, u32 Thread)
+		{
+			// a parent that didn't fit means its children don't either
+			if (Depth > 0 && Parent < 0)
+				return -1;
+
+			for (u32 i = 0; i < Frame.NumNodes; i++)
+			{
+				ZoneNode& Node = Frame.Nodes[i];
+				if (Node.Parent == Parent && Node.Thread == Thread && SameName(Node.Name, Name))
+					return (s32)i;
+			}
+
+			if (Frame.NumNodes == MaxNodes)
+				return -1;
+
+			ZoneNode& Node = Frame.Nodes[Frame.NumNodes];
+			Node = { Name, Parent, Depth, Thread, 0, 0 };
+			return (s32)Frame.NumNodes++;
+		}
+
+		static void ProcessLog(ThreadLog* Log, FrameSummary& Frame, bool Capturing)
+		{
+			u64 Write = Log->Write;
+			CompilerBarrier();
+
+			// the thread lapped us, the open zone stack can't be trusted any more
+			if (Write - Log->Read > LogSize)
+			{
+				Log->Read = Write - LogSize;
+				Log->Depth = 0;
+			}
+
+			// zones still open from earlier frames get nodes in this one
+			u32 OpenDepth = min(Log->Depth, MaxDepth);
+			for (u32 d = 0; d < OpenDepth; d++)
+			{
+				OpenZone& Open = Log->Stack[d];
+				Open.Node = FindNode(Frame, d ? Log->Stack[d - 1].Node : -1, Open.Name, d, Log->Index);
+			}
+
+			for (u64 r = Log->Read; r < Write; r++)
+			{
+				const Event& e = Log->Events[r & (LogSize - 1)];
+				if (e.Type == EventBegin)
+				{
+					u32 d = Log->Depth++;
+					if (d < MaxDepth)
+					{
+						s32 Parent = d ? Log->Stack[d - 1].Node : -1;
+						Log->Stack[d] = { e.Name, e.Time, FindNode(Frame, Parent, e.Name, d, Log->Index) };
+					}
+				}
+				else if (e.Type == EventEnd && Log->Depth > 0)
+				{
+					u32 d = --Log->Depth;
+					if (d < MaxDepth)
+					{
+						OpenZone& Open = Log->Stack[d];
+						if (Open.Node >= 0)
+						{
+							ZoneNode& Node = Frame.Nodes[Open.Node];
+							Node.Ticks += e.Time - Open.Start;
+							Node.Calls++;
+						}
+
+						// zones that were already open when the capture started are left out
+						if (Capturing && Open.Start >= TraceCapture.StartTicks)
+						{
+							AddCaptureEvent({ Open.Start, e.Time - Open.Start, Open.Name, 0, CaptureZone, Log->Index, 0 });
+						}
+					}
+				}
+				else if (e.Type == EventCounter && Capturing && e.Time >= TraceCapture.StartTicks)
+				{
+					AddCaptureEvent({ e.Time, 0, e.Name, e.Value, CaptureCounter, Log->Index, 0 });
+				}
+			}
+			Log->Read = Write;
+		}
+
+		static str8 FormatMicroseconds(Arena& arena, u64 Ticks, double TicksPerSecond)
+		{
+			u64 Nanoseconds = (u64)(Ticks * 1e9 / TicksPerSecond);
+			return str8::format(arena, "{}.{:03}", (u32)(Nanoseconds / 1000), (u32)(Nanoseconds % 1000));
+		}
+
+		static void FlushText()
+		{
+			Arena& Text = TraceCapture.Text;
+			fwrite(Text.BaseAddress, 1, Text.CurrentLocation - Text.BaseAddress, TraceCapture.File);
+			Text.Clear();
+		}
+
+		// names go into the file unescaped, zone and counter names are expected to be plain literals
+		static void WriteEvent(const CaptureEvent& e, double TicksPerSecond)
+		{
+			Arena& Text = TraceCapture.Text;
+			char ScratchSpace[128];
+			Arena Scratch = Arena::GetScratchArena((u8*)ScratchSpace, sizeof(ScratchSpace));
+
+			if (!(TraceCapture.NamedThreads & (1ull << e.Thread)))
+			{
+				TraceCapture.NamedThreads |= 1ull << e.Thread;
+				str8 ThreadName = e.Thread == TraceCapture.MainThread ? str8("Main") : str8::format(Scratch, "Thread {}", e.Thread);
+				str8::format(Text, "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+					TraceCapture.FirstEvent ? "" : ",\n", e.Thread, ThreadName);
+				TraceCapture.FirstEvent = false;
+				Scratch.Clear();
+			}
+
+			const char* Separator = TraceCapture.FirstEvent ? "" : ",\n";
+			TraceCapture.FirstEvent = false;
+
+			// timestamps are microseconds since BeginCapture
+			str8 Start = FormatMicroseconds(Scratch, e.Start - TraceCapture.StartTicks, TicksPerSecond);
+			str8 Duration = FormatMicroseconds(Scratch, e.Ticks, TicksPerSecond);
+			switch (e.Type)
+			{
+			case CaptureZone:
+				str8::format(Text, "{}{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{},\"dur\":{}}}",
+					Separator, e.Name, e.Thread, Start, Duration);
+				break;
+			case CaptureCounter:
+				str8::format(Text, "{}{{\"name\":\"{}\",\"ph\":\"C\",\"pid\":1,\"tid\":{},\"ts\":{},\"args\":{{\"value\":{}}}}}",
+					Separator, e.Name, e.Thread, Start, e.Value);
+				break;
+			case CaptureFrame:
+				str8::format(Text, "{}{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{},\"dur\":{},\"args\":{{\"frame\":{}}}}}",
+					Separator, e.Name, e.Thread, Start, Duration, e.Frame);
+				break;
+			}
+		}
+
+		static void WriterMain(void*)
+		{
+			for (;;)
+			{
+				TraceCapture.WakeUp.Wait();
+
+				Arena* Batch = TraceCapture.Pending;
+				if (Batch)
+				{
+					double TicksPerSecond = TraceCapture.PendingTicksPerSecond;
+					CaptureEvent* Events = (CaptureEvent*)Batch->BaseAddress;
+					size_t Count = (Batch->CurrentLocation - Batch->BaseAddress) / sizeof(CaptureEvent);
+					for (size_t i = 0; i < Count; i++)
+					{
+						WriteEvent(Events[i], TicksPerSecond);
+
+						// leave room for one more line
+						if (TraceCapture.Text.CurrentLocation + 1024 > TraceCapture.Text.BaseAddress + TraceCapture.Text.Size)
+						{
+							FlushText();
+						}
+					}
+					FlushText();
+					TraceCapture.Pending = nullptr;
+				}
+
+				bool Stopping = TraceCapture.Stopping != 0;
+				AtomicFence();
+				TraceCapture.Busy = 0;
+				if (Stopping)
+					return;
+			}
+		}
+
+		// only called with the writer idle
+		static void HandOffCapture()
+		{
+			// rdtsc against the OS clock over the whole capture so far
+			TraceCapture.ElapsedSeconds += TraceCapture.ElapsedTimer.GetSecondsSinceLast();
+			u64 Ticks = __rdtsc() - TraceCapture.StartTicks;
+
+			TraceCapture.PendingTicksPerSecond = TraceCapture.ElapsedSeconds > 0 ? Ticks / TraceCapture.ElapsedSeconds : TicksPerSecond;
+			TraceCapture.Pending = &TraceCapture.Buffers[TraceCapture.Front];
+			TraceCapture.Front ^= 1;
+			TraceCapture.Buffers[TraceCapture.Front].Clear();
+			TraceCapture.Busy = 1;
+			AtomicFence();
+			TraceCapture.WakeUp.Signal();
+		}
+
+		bool BeginCapture(const char* Filename, u32 NumFrames)
+		{
+			// the events and the frame countdown only exist in a profiling build, don't write an empty trace
+#if !JOGO_PROFILE
+			DebugOut(str8("profiler capture: this build has no profiler, configure with JOGO_PROFILE on\n"));
+			return false;
+#else
+			if (TraceCapture.Active)
+				return false;
+
+			Capture& c = TraceCapture;
+			if (fopen_s(&c.File, Filename, "wb"))
+				return false;
+
+			c.Buffers[0] = Arena::Create(CaptureBufferSize);
+			c.Buffers[1] = Arena::Create(CaptureBufferSize);
+			c.Text = Arena::Create(CaptureTextSize, 1);
+			if (!c.Buffers[0].BaseAddress || !c.Buffers[1].BaseAddress || !c.Text.BaseAddress || !c.WakeUp.Create())
+			{
+				c.Buffers[0].ReleaseMemory();
+				c.Buffers[1].ReleaseMemory();
+				c.Text.ReleaseMemory();
+				fclose(c.File);
+				return false;
+			}
+
+			fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", c.File);
+			c.Front = 0;
+			c.Pending = nullptr;
+			c.Busy = 0;
+			c.Stopping = 0;
+			c.FirstEvent = true;
+			c.NamedThreads = 0;
+			c.FramesLeft = NumFrames;
+			c.NumEvents = 0;
+			c.Dropped = 0;
+			c.ElapsedSeconds = 0;
+			c.ElapsedTimer.Start();
+			c.StartTicks = __rdtsc();
+			c.Writer.Start(WriterMain, nullptr);
+			c.Active = true;
+			return true;
+#endif
+		}
+
+		void EndCapture()
+		{
+			Capture& c = TraceCapture;
+			if (!c.Active)
+				return;
+
+			c.Active = false;
+			while (c.Busy)
+			{
+				SpinPause();
+			}
+
+			// the last batch goes with the stop request
+			c.Stopping = 1;
+			HandOffCapture();
+			c.Writer.Join();
+
+			fputs("\n]}\n", c.File);
+			fclose(c.File);
+			c.WakeUp.Release();
+			c.Buffers[0].ReleaseMemory();
+			c.Buffers[1].ReleaseMemory();
+			c.Text.ReleaseMemory();
+
+			char Message[128];
+			Arena MessageArena = Arena::GetScratchArena((u8*)Message, sizeof(Message));
+			DebugOut(str8::format(MessageArena, "profiler capture: {} events, {} dropped\n", c.NumEvents, c.Dropped));
+		}
+
+		bool IsCapturing()
+		{
+			return TraceCapture.Active;
+		}
+
+		// without JOGO_PROFILE there are no zones to summarise, so a frame costs nothing either
+		void BeginFrame()
+		{
+#if JOGO_PROFILE
+			FrameStart = __rdtsc();
+#endif
+		}
+
+		void EndFrame()
+		{
+#if JOGO_PROFILE
+			u64 Now = __rdtsc();
+
+			// rdtsc runs at a fixed rate on anything recent, measure it against the OS clock every frame
+			double Seconds = CalibrationTimer.GetSecondsSinceLast();
+			if (CalibrationTicks && Seconds > 0)
+			{
+				TicksPerSecond = (Now - CalibrationTicks) / Seconds;
+			}
+			CalibrationTicks = Now;
+
+			FrameSummary& Frame = Summaries[CurrentSummary ^ 1];
+			Frame.NumNodes = 0;
+
+			bool Capturing = TraceCapture.Active;
+			s32 Count = min(NumLogs, (s32)MaxThreads);
+			for (s32 i = 0; i < Count; i++)
+			{
+				// a thread may have claimed its slot but not filled it in yet
+				if (Logs[i])
+				{
+					ProcessLog(Logs[i], Frame, Capturing);
+				}
+			}
+
+			Frame.FrameTicks = FrameStart ? Now - FrameStart : 0;
+			Frame.FrameNumber = FrameNumber++;
+			CurrentSummary ^= 1;
+
+			if (Capturing)
+			{
+				ThreadLog* Log = GetLog();
+				TraceCapture.MainThread = Log ? Log->Index : 0;
+				if (FrameStart >= TraceCapture.StartTicks)
+				{
+					AddCaptureEvent({ FrameStart, Frame.FrameTicks, "Frame", 0, CaptureFrame, TraceCapture.MainThread, Frame.FrameNumber });
+				}
+
+				if (TraceCapture.FramesLeft && !--TraceCapture.FramesLeft)
+				{
+					EndCapture();
+				}
+				else if (!TraceCapture.Busy)
+				{
+					HandOffCapture();
+				}
+			}
+#endif
+		}
+
+		const FrameSummary& GetLastFrame()
+		{
+			return Summaries[CurrentSummary];
+		}
+
+		double TicksToMilliseconds(u64 Ticks)
+		{
+			return TicksPerSecond > 0 ? Ticks * 1000.0 / TicksPerSecond : 0.0;
+		}
+
+		static s32 DrawNode(const FrameSummary& Frame, s32 Index, Bitmap& Target, Font& TextFont, s32 x, s32 y, Arena& arena)
+		{
+			const ZoneNode& Node = Frame.Nodes[Index];
+			s32 CharWidth = (s32)TextFont.CharacterWidth;
+			u32 TextColor = 0xffffff;
+			u32 BackColor = 0xff000000;
+
+			str8 Name(Node.Name, str8::cstringlength(Node.Name));
+			if (Node.Parent < 0 && Node.Thread)
+			{
+				Name = str8::format(arena, "[{}] {}", Node.Thread, Name);
+			}
+			TextFont.DrawText(x + Node.Depth * 2 * CharWidth, y, Name, TextColor, BackColor, Target);
+			TextFont.DrawText(x + 28 * CharWidth, y, str8::format(arena, "{:7.2} ms {:5}", (float)TicksToMilliseconds(Node.Ticks), Node.Calls), TextColor, BackColor, Target);
+			y += TextFont.CharacterHeight;
+
+			// children were added after their parent, depth first keeps them under it
+			for (u32 i = Index + 1; i < Frame.NumNodes; i++)
+			{
+				if (Frame.Nodes[i].Parent == Index)
+				{
+					y = DrawNode(Frame, i, Target, TextFont, x, y, arena);
+				}
+			}
+			return y;
+		}
+
+		void DrawOverlay(Bitmap& Target, Font& TextFont, s32 x, s32 y, Arena& arena)
+		{
+			const FrameSummary& Frame = GetLastFrame();
+			s32 LineHeight = (s32)TextFont.CharacterHeight;
+			s32 Width = 45 * (s32)TextFont.CharacterWidth;
+			Target.FillRect({ x, y, Width, (s32)(Frame.NumNodes + 1) * LineHeight }, 0);
+
+			TextFont.DrawText(x, y, str8::format(arena, "frame {}: {:0.2} ms", Frame.FrameNumber, (float)TicksToMilliseconds(Frame.FrameTicks)), 0xffff00, 0xff000000, Target);
+			y += LineHeight;
+
+			for (u32 i = 0; i < Frame.NumNodes; i++)
+			{
+				if (Frame.Nodes[i].Parent < 0)
+				{
+					y = DrawNode(Frame, i, Target, TextFont, x, y, arena);
+				}
+			}
+		}
+	};
+};
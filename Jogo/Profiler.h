@@ -0,0 +1,77 @@
+#pragma once
+#include "int_types.h"
+#include "Platform.h"
+
+struct Bitmap;
+struct Font;
+struct Arena;
+
+// zones are only recorded when built with JOGO_PROFILE=1, otherwise JOGO_ZONE expands to nothing
+#ifndef JOGO_PROFILE
+#define JOGO_PROFILE 0
+#endif
+
+#define JOGO_ZONE_CONCAT2(a, b) a##b
+#define JOGO_ZONE_CONCAT(a, b) JOGO_ZONE_CONCAT2(a, b)
+
+#if JOGO_PROFILE
+#define JOGO_ZONE(Name) Jogo::Profiler::Zone JOGO_ZONE_CONCAT(ProfileZone, __LINE__)(Name)
+#define JOGO_COUNTER(Name, Value) Jogo::Profiler::RecordCounter(Name, (float)(Value))
+#else
+#define JOGO_ZONE(Name)
+#define JOGO_COUNTER(Name, Value)
+#endif
+
+namespace Jogo
+{
+	namespace Profiler
+	{
+		// Name must be a string literal or otherwise outlive the profiler
+		void BeginZone(const char* Name);
+		void EndZone();
+		void RecordCounter(const char* Name, float Value);
+
+		struct Zone
+		{
+			Zone(const char* Name) { BeginZone(Name); }
+			~Zone() { EndZone(); }
+		};
+
+		// one entry per distinct call path seen during the frame
+		struct ZoneNode
+		{
+			const char* Name;
+			s32 Parent;		// -1 for a thread's top level zones
+			u32 Depth;
+			u32 Thread;
+			u32 Calls;
+			u64 Ticks;
+		};
+
+		static const u32 MaxNodes = 256;
+
+		struct FrameSummary
+		{
+			ZoneNode Nodes[MaxNodes];
+			u32 NumNodes;
+			u64 FrameTicks;
+			u32 FrameNumber;
+		};
+
+		// called by Jogo::Run around every frame
+		void BeginFrame();
+		void EndFrame();
+
+		const FrameSummary& GetLastFrame();
+		double TicksToMilliseconds(u64 Ticks);
+
+		void DrawOverlay(Bitmap& Target, Font& TextFont, s32 x, s32 y, Arena& arena);
+
+		// writes the next NumFrames frames (0 = until EndCapture) to a chrome://tracing / Perfetto JSON file
+		// events are handed to a writer thread once a frame, so the frame only pays for copying them
+		// false without JOGO_PROFILE, there are no events to write
+		bool BeginCapture(const char* Filename, u32 NumFrames = 0);
+		void EndCapture();
+		bool IsCapturing();
+	};
+};
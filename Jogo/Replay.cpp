@@ -0,0 +1,175 @@
+#include "Jogo.h"
+#include "Replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Jogo
+{
+	namespace Replay
+	{
+		static const u32 Magic = 'J' | 'R' << 8 | 'E' << 16 | 'C' << 24;
+		static const u32 Version = 1;
+
+		struct FileHeader
+		{
+			u32 Magic;
+			u32 Version;
+			u32 Seed;
+			u32 Reserved;
+		};
+
+		// every frame is its time and event count, followed by the events packed into EventSize bytes each
+		static const u32 FrameHeaderSize = 6;
+		static const u32 EventSize = 9;
+		static const u32 MaxFrameEvents = 1024;
+
+		FILE* RecordFile = nullptr;
+		FILE* PlaybackFile = nullptr;
+		u8 FrameEvents[MaxFrameEvents * EventSize];
+		u32 NumFrameEvents = 0;
+
+		static void RecordEvent(const Input::Event& e)
+		{
+			if (NumFrameEvents == MaxFrameEvents)
+				return;
+
+			u8* p = FrameEvents + NumFrameEvents++ * EventSize;
+			s16 x = (s16)e.x;
+			s16 y = (s16)e.y;
+			p[0] = (u8)e.Type;
+			memcpy(p + 1, &e.Value, 4);
+			memcpy(p + 5, &x, 2);
+			memcpy(p + 7, &y, 2);
+		}
+
+		bool BeginRecording(const char* Filename)
+		{
+			if (RecordFile || fopen_s(&RecordFile, Filename, "wb"))
+				return false;
+
+			FileHeader Header = { Magic, Version, GetRandomSeed(), 0 };
+			fwrite(&Header, sizeof(Header), 1, RecordFile);
+			NumFrameEvents = 0;
+			Input::SetEventHook(RecordEvent);
+			return true;
+		}
+
+		void EndRecording()
+		{
+			if (!RecordFile)
+				return;
+
+			Input::SetEventHook(nullptr);
+			fclose(RecordFile);
+			RecordFile = nullptr;
+		}
+
+		bool IsRecording()
+		{
+			return RecordFile != nullptr;
+		}
+
+		void RecordFrame(float FrameSeconds)
+		{
+			if (!RecordFile)
+				return;
+
+			u8 FrameHeader[FrameHeaderSize];
+			u16 Count = (u16)NumFrameEvents;
+			memcpy(FrameHeader, &FrameSeconds, 4);
+			memcpy(FrameHeader + 4, &Count, 2);
+			fwrite(FrameHeader, FrameHeaderSize, 1, RecordFile);
+			fwrite(FrameEvents, EventSize, NumFrameEvents, RecordFile);
+			NumFrameEvents = 0;
+		}
+
+		static bool ReadHeader(FILE* File, FileHeader& Header)
+		{
+			return fread(&Header, sizeof(Header), 1, File) == 1 && Header.Magic == Magic && Header.Version == Version;
+		}
+
+		bool BeginPlayback(const char* Filename)
+		{
+			if (PlaybackFile || fopen_s(&PlaybackFile, Filename, "rb"))
+				return false;
+
+			FileHeader Header;
+			if (!ReadHeader(PlaybackFile, Header))
+			{
+				DebugOut("not a Jogo recording\n");
+				fclose(PlaybackFile);
+				PlaybackFile = nullptr;
+				return false;
+			}
+			return true;
+		}
+
+		void EndPlayback()
+		{
+			if (PlaybackFile)
+			{
+				fclose(PlaybackFile);
+				PlaybackFile = nullptr;
+			}
+		}
+
+		bool IsPlaying()
+		{
+			return PlaybackFile != nullptr;
+		}
+
+		bool NextFrame(float& FrameSeconds)
+		{
+			u8 FrameHeader[FrameHeaderSize];
+			if (!PlaybackFile || fread(FrameHeader, FrameHeaderSize, 1, PlaybackFile) != 1)
+				return false;
+
+			u16 Count;
+			memcpy(&FrameSeconds, FrameHeader, 4);
+			memcpy(&Count, FrameHeader + 4, 2);
+			if (Count > MaxFrameEvents || fread(FrameEvents, EventSize, Count, PlaybackFile) != Count)
+				return false;
+
+			for (u32 i = 0; i < Count; i++)
+			{
+				const u8* p = FrameEvents + i * EventSize;
+				s32 Value;
+				s16 x;
+				s16 y;
+				memcpy(&Value, p + 1, 4);
+				memcpy(&x, p + 5, 2);
+				memcpy(&y, p + 7, 2);
+				Input::PostEvent((Input::EventType)p[0], Value, x, y);
+			}
+			return true;
+		}
+	};
+
+	// apps seed from their constructors, before Run has looked at JOGO_REPLAY, so the seed goes and gets it
+	u32 GetRandomSeed()
+	{
+		static u32 Seed = 0;
+		if (!Seed)
+		{
+			FILE* File;
+			const char* ReplayName = getenv("JOGO_REPLAY");
+			Replay::FileHeader Header;
+			if (ReplayName && !fopen_s(&File, ReplayName, "rb"))
+			{
+				if (Replay::ReadHeader(File, Header))
+				{
+					Seed = Header.Seed;
+				}
+				fclose(File);
+			}
+
+			// xorshift gets stuck on 0
+			if (!Seed)
+			{
+				Seed = (u32)Timer::GetTicks() | 1;
+			}
+		}
+		return Seed;
+	}
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "int_types.h"
+
+namespace Jogo
+{
+	namespace Replay
+	{
+		// a recording is the random seed, then every frame's elapsed time and the input events Run drained for it
+		// playing it back through RunFrame gives the app exactly the same Ticks and input, as fast as it can draw
+		// Run records with JOGO_RECORD=file and plays back with JOGO_REPLAY=file
+		bool BeginRecording(const char* Filename);
+		void EndRecording();
+		bool IsRecording();
+
+		bool BeginPlayback(const char* Filename);
+		void EndPlayback();
+		bool IsPlaying();
+
+		// posts the next recorded frame's input and returns its frame time, false once the recording runs out
+		bool NextFrame(float& FrameSeconds);
+
+		// called by RunFrame once input has been drained, does nothing unless recording
+		void RecordFrame(float FrameSeconds);
+	};
+
+	// seed for Random that replays reproduce, the same value for the whole run
+	u32 GetRandomSeed();
+};
@@ -1,6 +1,7 @@
 #include "UI.h"
 #include "Input.h"
 #include "Font.h"
+#include <math.h>
 
 namespace UI
 {
@@ -67,16 +68,23 @@ namespace UI
 		Jogo::SetTickHandler(UITick);
 	}
 
-	void UITick(float DeltaTime)
+	void UITick(float ElapsedSeconds)
 	{
-		CursorTime += DeltaTime;
+		// after a long idle wait only the phase of the blink matters
+		CursorTime += ElapsedSeconds;
 		if (CursorTime > CursorBlinkInterval)
 		{
 			bTextEditCursorVisible = !bTextEditCursorVisible;
-			CursorTime -= CursorBlinkInterval;
+			CursorTime = fmodf(CursorTime - CursorBlinkInterval, CursorBlinkInterval);
+		}
+		DoubleClickTime += ElapsedSeconds;
+		TripleClickTime += ElapsedSeconds;
+
+		// an on demand app still has to blink the cursor
+		if (FocusID)
+		{
+			Jogo::RequestRedrawIn(CursorBlinkInterval - CursorTime);
 		}
-		DoubleClickTime += DeltaTime;
-		TripleClickTime += DeltaTime;
 	}
 
 	void ClearSelection()
@@ -403,16 +411,20 @@ namespace UI
 	bool Interact(u32 Id, const Bitmap::Rect& r)
 	{
 		bool clicked = false;
-		s32 mousex;
-		s32 mousey;
+		u32 OldHotID = HotID;
+		u32 OldActiveID = ActiveID;
 
-		Input::GetMousePos(mousex, mousey);
+		// every widget reads the same snapshot
+		const Input::InputState& State = Input::GetState();
+		s32 mousex = State.MouseX;
+		s32 mousey = State.MouseY;
+		bool LeftDown = State.IsDown(Input::BUTTON_LEFT);
 
 		if (ActiveID == Id)
 		{
 			HiColor = LoLight;
 			LoColor = HiLight;
-			if (!Input::IsKeyPressed(Input::BUTTON_LEFT))
+			if (!LeftDown)
 			{
 				if (HotID == Id)
 				{
@@ -423,7 +435,7 @@ namespace UI
 		}
 		else if (Id == HotID)
 		{
-			if (Input::IsKeyPressed(Input::BUTTON_LEFT))
+			if (LeftDown)
 			{
 				ActiveID = Id;
 			}
@@ -432,7 +444,7 @@ namespace UI
 		// SetHot
 		if (mousex >= r.x && mousex < r.x + r.w && mousey >= r.y && mousey < r.y + r.h)
 		{
-			if (ActiveID == Id || (ActiveID == 0 && !Input::IsKeyPressed(Input::BUTTON_LEFT)))
+			if (ActiveID == Id || (ActiveID == 0 && !LeftDown))
 			{
 				HotID = Id;
 				CurrentColor = HotColor;
@@ -443,6 +455,12 @@ namespace UI
 			HotID = 0;
 		}
 
+		// the widget changed state or the app is about to react to a click, either way the next frame looks different
+		if (clicked || HotID != OldHotID || ActiveID != OldActiveID)
+		{
+			Jogo::RequestRedraw();
+		}
+
 		return clicked;
 	}
 
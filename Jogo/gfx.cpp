@@ -1,6 +1,7 @@
 #include "gfx.h"
 #include "Bitmap.h"
 #include "Arena.h"
+#include "Profiler.h"
 
 namespace Jogo
 {
@@ -87,6 +88,8 @@ namespace Jogo
 	// Maybe Camera, that has VT, Frustum, Projection
 	void RenderMesh(const Mesh& mesh, const Matrix4& ModelToWorld, const Camera& camera, Bitmap& Target, const Bitmap& Texture, Arena& arena, bool fillTL)
 	{
+		JOGO_ZONE("RenderMesh");
+
 		// build MVT transform
 		Matrix4 View = camera.GetInverse();;
 		Matrix4 MVT = ModelToWorld * View;
@@ -102,8 +105,8 @@ namespace Jogo
 		Matrix3 NormalMVT = (Matrix3)MVT;
 		NormalMVT.Normalize();
 
-		RenderVertex* RenderVerts = (RenderVertex*)arena.Allocate((3 * mesh.NumVerts) * sizeof(RenderVertex));
-		u16* VisibleTris = (u16*)arena.Allocate(mesh.NumTris * 3 * 2 * sizeof(u16));
+		RenderVertex* RenderVerts = (RenderVertex*)JOGO_ALLOCATE(arena, (3 * mesh.NumVerts) * sizeof(RenderVertex));
+		u16* VisibleTris = (u16*)JOGO_ALLOCATE(arena, mesh.NumTris * 3 * 2 * sizeof(u16));
 
 		RenderVertex* VertIter = RenderVerts;
 		for (u32 i = 0; i < mesh.NumVerts; i++, VertIter++)
@@ -186,6 +189,8 @@ namespace Jogo
 			}
 		}
 
+		JOGO_COUNTER("VisibleTris", (VisibleTriIter - VisibleTris) / 3);
+
 		for (u16* TriIter = VisibleTris; TriIter < VisibleTriIter; TriIter += 3)
 		{
 			RenderVertex& p = RenderVerts[TriIter[0]];
@@ -225,8 +230,8 @@ namespace Jogo
 	{
 		u64 verts = numVerts;
 
-		// TODO: use scratch allocation from an arena instead of alloca
-		Vector3* a = (Vector3*)alloca(sizeof(Vector3) * (numVerts + 6));
+		TempMemory Scratch = GetScratch();
+		Vector3* a = (Vector3*)Scratch.Allocate(sizeof(Vector3) * (numVerts + 6));
 
 		verts = planes[0].ClipPoly(verts, pIn, a);
 		if (!verts) return 0;
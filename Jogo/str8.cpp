@@ -51,8 +51,9 @@ namespace Jogo
 		u32 numdigits = 8;
 		if (!leadingzeros)
 		{
-			if (_BitScanReverse((unsigned long*)&numdigits, number))
-				numdigits = (numdigits + 4) >> 2;
+			unsigned long highbit;
+			if (_BitScanReverse(&highbit, number))
+				numdigits = ((u32)highbit + 4) >> 2;
 			else
 				numdigits = 1;
 		}
@@ -552,42 +553,30 @@ namespace Jogo
 			len = itohex(number, intchars, 63, false, (bits & SPEC_HEX_UPPER) != 0);
 		}
 		else
-			len = itoa(number, intchars, 63, isSigned);
+			len = itoa(neg ? 0u - number : number, intchars, 63, false);
 
-		u32 result = len;
+		// the width counts the sign, like printf's, and the result is exactly what was written
+		u32 result = len + neg;
 		u32 width = 0;
 		if (bits & SPEC_WIDTH)
 			width = (bits >> SPEC_WIDTH_SHIFT) & SPEC_WIDTH_MASK;
+		u32 diff = width > result ? width - result : 0;
+		char fill = (bits & SPEC_ZERO) ? '0' : ' ';
 		char* p = stringspace;
-		if (width > len)
+		if (neg && fill == '0')
+			*p++ = '-';
+		for (u32 i = 0; i < diff; i++)
 		{
-			char fill = ' ';
-			if (bits & SPEC_ZERO)
-			{
-				fill = '0';
-				if (neg)
-				{
-					*p++ = '-';
-					width--;
-				}
-			}
-			u32 diff = width - len;
-			while (diff--)
-			{
-				*p++ = fill;
-			}
-			result = width + neg;
+			*p++ = fill;
 		}
-		char* q = intchars;
-		u32 l = len;
-		if (neg && !(bits & SPEC_ZERO))
+		if (neg && fill == ' ')
 			*p++ = '-';
-		while (l--)
+		for (u32 i = 0; i < len; i++)
 		{
-			*p++ = *q++;
+			*p++ = intchars[i];
 		}
 
-		return result;
+		return result + diff;
 	}
 
 	u32 str8::toString(f32 fnumber, const str8& spec, char* stringspace, u32 maxlen)
@@ -1,6 +1,6 @@
 
 #pragma once
-#include <intrin.h>
+#include "Platform.h"
 #include "int_types.h"
 #include "Arena.h"
 #include "JMath.h"
@@ -209,40 +209,70 @@ namespace Jogo
 			u32 bits = parseSpec(spec);
 			size_t len = cstringlength(string);
 			len = Jogo::min(len, maxlen);
+			u32 diff = 0;
 			if (bits & SPEC_WIDTH)
 			{
 				u32 width = (bits >> SPEC_WIDTH_SHIFT) & SPEC_WIDTH_MASK;
 				if (width > len)
 				{
-					u32 diff = width - (u32)len;
-					len += diff;
+					// the padding goes in front, then only the string's own characters
+					diff = width - (u32)len;
 					for (u32 i = 0; i < diff; i++)
 						*stringspace++ = ' ';
 				}
 			}
 			copystring(string, stringspace, len, maxlen);
-			return (u32)len;
+			return (u32)len + diff;
 		}
 
 		static u32 toString(const str8& string, const str8& spec, char* stringspace, size_t maxlen)
 		{
 			u32 bits = parseSpec(spec);
 			size_t len = Jogo::min(string.len, maxlen);
+			u32 diff = 0;
 			if (bits & SPEC_WIDTH)
 			{
 				u32 width = (bits >> SPEC_WIDTH_SHIFT) & SPEC_WIDTH_MASK;
 				if (width > len)
 				{
-					u32 diff = width - (u32)len;
-					len += diff;
+					// the padding goes in front, then only the string's own characters
+					diff = width - (u32)len;
 					for (u32 i = 0; i < diff; i++)
 						*stringspace++ = ' ';
 				}
 			}
 			copystring(string.chars, stringspace, len, maxlen);
-			return (u32)len;
+			return (u32)len + diff;
 		}
 
+		// how many chars toString would write, without writing them
+		static u32 measure(u32 number, const str8& spec)
+		{
+			char scratch[SPEC_WIDTH_MASK + 64];
+			return toString(number, spec, scratch, sizeof(scratch));
+		}
+		static u32 measure(s32 number, const str8& spec)
+		{
+			char scratch[SPEC_WIDTH_MASK + 64];
+			return toString(number, spec, scratch, sizeof(scratch));
+		}
+		static u32 measure(f32 fnumber, const str8& spec)
+		{
+			char scratch[SPEC_WIDTH_MASK + 256];
+			return toString(fnumber, spec, scratch, sizeof(scratch));
+		}
+		static u32 measure(const char* string, const str8& spec)
+		{
+			return measure(str8(string, cstringlength(string)), spec);
+		}
+		static u32 measure(const str8& string, const str8& spec)
+		{
+			u32 bits = parseSpec(spec);
+			u32 width = (bits & SPEC_WIDTH) ? (bits >> SPEC_WIDTH_SHIFT) & SPEC_WIDTH_MASK : 0;
+			return (u32)Jogo::max(string.len, (size_t)width);
+		}
+
+		// with a null dest only counts, so format can allocate exactly what it's about to write
 		struct formatter
 		{
 			u32 format(const str8& fmt, char* dest, auto arg, auto... rest)
@@ -250,7 +280,7 @@ namespace Jogo
 				// find all escaped braces
 				u32 pos = 0;
 				str8 fmtsub = fmt;
-				char* d = dest;
+				u32 n = 0;
 				s32 opened = -1;
 				s32 closed = -1;
 
@@ -266,7 +296,7 @@ namespace Jogo
 						else if (pos + 1 < fmtsub.len && fmtsub[pos + 1] == '{')
 						{
 							// put escaped { in output
-							*d++ = '{';
+							put(dest, n, '{');
 							pos += 2;
 						}
 						else
@@ -285,7 +315,7 @@ namespace Jogo
 						}
 						else if (pos + 1 < fmtsub.len && fmtsub[pos + 1] == '}')
 						{
-							*d++ = '}';
+							put(dest, n, '}');
 							pos += 2;
 						}
 						else
@@ -297,7 +327,7 @@ namespace Jogo
 					}
 					if (opened == -1)
 					{
-						*d++ = fmtsub[pos];
+						put(dest, n, fmtsub[pos]);
 						pos++;
 					}
 					else
@@ -308,26 +338,24 @@ namespace Jogo
 
 				if (closed == -1)
 				{
-					return (u32)(d-dest);
+					return n;
 				}
 
 				// pass format specifiers to toString
 				str8 spec = fmtsub.substr(opened, closed - opened);
-				u32 l = toString(arg, spec, d, (u32)-1);
-				d += l;
-				u32 len = (u32)(d - dest);
+				n += dest ? toString(arg, spec, dest + n, (u32)-1) : measure(arg, spec);
 
 				if (closed < fmtsub.len)
-					return len + format(fmtsub.substr(closed), d, rest...);
+					return n + format(fmtsub.substr(closed), dest ? dest + n : nullptr, rest...);
 
-				return len;
+				return n;
 			}
 
 			// ran out of parameters, output the remainder of the format string
 			u32 format(const str8& fmt, char* dest)
 			{
 				u32 pos = 0;
-				char* d = dest;
+				u32 n = 0;
 
 				// replace double braces in the remainder of the format string...
 				while (pos < fmt.len)
@@ -336,7 +364,7 @@ namespace Jogo
 					{
 						if (pos + 1 < fmt.len && fmt[pos + 1] == '{')
 						{
-							*d++ = '{';
+							put(dest, n, '{');
 							pos += 2;
 						}
 						else
@@ -348,7 +376,7 @@ namespace Jogo
 					{
 						if (pos + 1 < fmt.len && fmt[pos + 1] == '}')
 						{
-							*d++ = '}';
+							put(dest, n, '}');
 							pos += 2;
 						}
 						else
@@ -358,27 +386,37 @@ namespace Jogo
 					}
 					else
 					{
-						*d++ = fmt[pos++];
+						put(dest, n, fmt[pos++]);
 					}
 				}
 
-				return (u32)(d - dest);
+				return n;
 			}
 
+			static void put(char* dest, u32& n, char c)
+			{
+				if (dest)
+				{
+					dest[n] = c;
+				}
+				n++;
+			}
 		};
 
+		// measures first, then writes into exactly that much of the arena, an empty str8 if it doesn't fit
 		template <typename... Args>
 		static str8 format(Arena& arena, const str8& fmt, const Args&... args)
 		{
-			str8 newstr;
-			char* newchars = (char*)arena.Allocate(0);
-
 			formatter format_arg;
+			size_t len = (size_t)format_arg.format(fmt, nullptr, args...);
 
-			newstr.len = (size_t)format_arg.format(fmt, newchars, args...);
+			char* newchars = (char*)JOGO_ALLOCATE(arena, len);
+			if (!newchars)
+				return str8("");
 
+			str8 newstr;
 			newstr.chars = newchars;
-			arena.Allocate(newstr.len);	// bump arena by size of string
+			newstr.len = (size_t)format_arg.format(fmt, newchars, args...);
 			return newstr;
 		}
 
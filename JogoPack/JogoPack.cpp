@@ -0,0 +1,185 @@
+#include "Jogo.h"
+#include "Bitmap.h"
+#include "Font.h"
+#include "Pack.h"
+#include "Intern.h"
+#include <stdio.h>
+
+using namespace Jogo;
+
+// JogoPack Output.jpak Asset...
+// packs each .bmp and .fnt named on the command line under the name it was given, so run it from the app's
+// directory with the same paths the app loads them by, e.g. from Tetris:
+//	JogoPack Assets.jpak tetrisback.bmp ../Jogo/Font16.fnt
+// every asset goes through the same Bitmap::Load and Font::Load the app would use, so the pack holds exactly
+// what loading the loose files gives
+
+static u64 AlignBlob(u64 Offset)
+{
+	return (Offset + Bitmap::RowAlignment - 1) & ~(u64)(Bitmap::RowAlignment - 1);
+}
+
+static bool EndsWith(const str8& String, const str8& End)
+{
+	return String.len >= End.len && !memcmp(String.chars + String.len - End.len, End.chars, End.len);
+}
+
+struct PackedAsset
+{
+	str8 Name;
+	Bitmap Image;
+	Font LoadedFont;
+	bool IsFont;
+};
+
+int main(int argc, char* argv[])
+{
+	Arena arena = Arena::CreateGrowable();
+	if (argc < 3)
+	{
+		Print("usage: JogoPack Output.jpak Asset...\n");
+		return 1;
+	}
+
+	// interning finds names given twice, and gives each asset the ID it's packed at
+	Interner Names = Interner::Create(arena);
+	Array<PackedAsset> Assets = Array<PackedAsset>::Create(arena);
+	for (int i = 2; i < argc; i++)
+	{
+		str8 Name(argv[i], str8::cstringlength(argv[i]));
+		if (Names.GetID(Name) < Assets.Count)
+		{
+			Printf(arena, "{} is named twice, packing it once\n", Name);
+			continue;
+		}
+
+		PackedAsset Asset = {};
+		Asset.Name = Names.Intern(Name);
+		Asset.IsFont = EndsWith(Name, ".fnt");
+		if (Asset.IsFont)
+		{
+			Asset.LoadedFont = Font::Load(argv[i], arena);
+			Asset.Image = Asset.LoadedFont.FontBitmap;
+		}
+		else
+		{
+			Asset.Image = Bitmap::Load(argv[i], arena);
+		}
+		if (!Asset.Image.Pixels)
+		{
+			Printf(arena, "can't load {}\n", Name);
+			return 1;
+		}
+		Assets.Add(Asset);
+	}
+
+	// lay the file out: header, entries, slots, names, then the blobs each on a RowAlignment boundary
+	PackHeader Header = {};
+	Header.Magic = PackHeader::MagicValue;
+	Header.Version = PackHeader::CurrentVersion;
+	Header.EntryCount = Assets.Count;
+	Header.SlotCount = 16;
+	while (Header.SlotCount < Assets.Count * 2)
+	{
+		Header.SlotCount *= 2;
+	}
+	Header.EntriesOffset = sizeof(PackHeader);
+	Header.SlotsOffset = Header.EntriesOffset + (u64)Assets.Count * sizeof(PackEntry);
+	Header.NamesOffset = Header.SlotsOffset + (u64)Header.SlotCount * sizeof(u32);
+
+	PackEntry* Entries = (PackEntry*)arena.Allocate(Assets.Count * sizeof(PackEntry));
+	u64 Offset = Header.NamesOffset;
+	for (u32 i = 0; i < Assets.Count; i++)
+	{
+		const PackedAsset& Asset = Assets[i];
+		PackEntry& Entry = Entries[i];
+		Entry = {};
+		Entry.Kind = Asset.IsFont ? PACK_FONT : PACK_BITMAP;
+		Entry.Hash = HashKey(Asset.Name);
+		Entry.NameOffset = Offset;
+		Entry.NameLength = (u32)Asset.Name.len;
+		Offset += Asset.Name.len + 1;
+	}
+	for (u32 i = 0; i < Assets.Count; i++)
+	{
+		const PackedAsset& Asset = Assets[i];
+		PackEntry& Entry = Entries[i];
+		Entry.Width = Asset.Image.Width;
+		Entry.Height = Asset.Image.Height;
+		Entry.PixelSize = Asset.Image.PixelSize;
+		Entry.Pitch = (u32)AlignBlob(Asset.Image.Width * Asset.Image.PixelSize);
+		Entry.PixelsOffset = Offset = AlignBlob(Offset);
+		Offset += (u64)Entry.Pitch * Entry.Height;
+		if (Asset.IsFont)
+		{
+			const Font& LoadedFont = Asset.LoadedFont;
+			Entry.CharacterMin = LoadedFont.CharacterMin;
+			Entry.CharacterCount = LoadedFont.CharacterCount;
+			Entry.CharacterWidth = LoadedFont.CharacterWidth;
+			Entry.CharacterHeight = LoadedFont.CharacterHeight;
+			Entry.Antialiased = LoadedFont.Antialiased;
+			if (LoadedFont.CharacterRects)
+			{
+				Entry.RectsOffset = Offset = AlignBlob(Offset);
+				Offset += (u64)LoadedFont.CharacterCount * sizeof(Bitmap::Rect);
+			}
+		}
+	}
+	Header.FileSize = Offset;
+
+	// the whole file is built in memory and written at once
+	u8* File = (u8*)arena.Allocate((size_t)Header.FileSize);
+	if (!File)
+	{
+		Print("out of memory\n");
+		return 1;
+	}
+	memset(File, 0, (size_t)Header.FileSize);
+	memcpy(File, &Header, sizeof(PackHeader));
+	memcpy(File + Header.EntriesOffset, Entries, Assets.Count * sizeof(PackEntry));
+
+	u32* Slots = (u32*)(File + Header.SlotsOffset);
+	u32 Mask = Header.SlotCount - 1;
+	for (u32 i = 0; i < Assets.Count; i++)
+	{
+		const PackedAsset& Asset = Assets[i];
+		const PackEntry& Entry = Entries[i];
+		u32 Slot = Entry.Hash & Mask;
+		while (Slots[Slot])
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+		Slots[Slot] = i + 1;
+
+		memcpy(File + Entry.NameOffset, Asset.Name.chars, Asset.Name.len);
+		for (u32 y = 0; y < Entry.Height; y++)
+		{
+			memcpy(File + Entry.PixelsOffset + (u64)y * Entry.Pitch, Asset.Image.GetRow((s32)y), Entry.Width * Entry.PixelSize);
+		}
+		if (Entry.RectsOffset)
+		{
+			memcpy(File + Entry.RectsOffset, Asset.LoadedFont.CharacterRects, Entry.CharacterCount * sizeof(Bitmap::Rect));
+		}
+	}
+
+	FILE* fp;
+	if (fopen_s(&fp, argv[1], "wb"))
+	{
+		Printf(arena, "can't write {}\n", (const char*)argv[1]);
+		return 1;
+	}
+	bool Written = fwrite(File, 1, (size_t)Header.FileSize, fp) == Header.FileSize;
+	fclose(fp);
+	if (!Written)
+	{
+		Printf(arena, "can't write {}\n", (const char*)argv[1]);
+		return 1;
+	}
+
+	Printf(arena, "{}: {} assets, {:0.1} KB\n", (const char*)argv[1], Assets.Count, (f32)Header.FileSize / 1024.0f);
+	for (const PackedAsset& Asset : Assets)
+	{
+		Printf(arena, "  {} {}x{} {}bpp{}\n", Asset.Name, Asset.Image.Width, Asset.Image.Height, Asset.Image.PixelSize * 8, Asset.IsFont ? " font" : "");
+	}
+	return 0;
+}
@@ -9,6 +9,8 @@ using namespace Jogo;
 
 
 #if 1
+#include <cfloat>
+#include <limits>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -93,7 +93,6 @@ class TetrisGame : public Jogo::App
 	s32 deltaX = 0, deltaY = 0;
 	bool dragging = false;
 
-	static const size_t GameArenaSize = 128 * 1024 * 1024;
 	Arena GameArena;
 	Bitmap TestBitmap; 
 	Jogo::Random RandomNumber;
@@ -104,9 +103,10 @@ public:
 
 	TetrisGame()
 	{
-		RandomNumber.State = (u32)GameTimer.Start();
-		GameArena = Arena::Create(GameArenaSize);
-		TestBitmap = Bitmap::Load("tetrisback.bmp", GameArena);
+		RandomNumber.State = Jogo::GetRandomSeed();
+		// the background and anything else loaded here is drawn every frame
+		GameArena = Arena::CreateGrowable(Arena::DefaultReserveSize, 0, Arena::DefaultCommitChunk, 8, true);
+		TestBitmap = Assets.LoadBitmap("tetrisback.bmp", GameArena);
 		ShuffleNextList();
 		CurrentPiece = NextPieceList[CurrentPieceIndex]; 
 		UI::Init(BackBuffer, DefaultFont);
@@ -535,7 +535,7 @@ public:
 				DefaultFont.DrawText((Width - MessageSize.w)/2, (Height + DefaultFont.CharacterHeight*3)/2, PressEnterToPlay, 0xffffff, 0, BackBuffer);
 			}
 		}
-		Jogo::Show(BackBuffer.PixelBGRA, Width, Height);
+		Jogo::Show(BackBuffer);
 	}
 
 	// TODO: handle resizing BackBuffer here
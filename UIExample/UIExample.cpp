@@ -26,7 +26,6 @@ class UIExample : public Jogo::App
 	s32 deltaX = 0, deltaY = 0;
 	bool dragging = false;
 
-	static const size_t GameArenaSize = 128 * 1024 * 1024;
 	Arena GameArena;
 	Bitmap TestBitmap;
 	Jogo::Random RandomNumber;
@@ -37,9 +36,12 @@ public:
 
 	UIExample()
 	{
-		RandomNumber.State = (u32)GameTimer.Start();
-		GameArena = Arena::Create(GameArenaSize);
+		RandomNumber.State = Jogo::GetRandomSeed();
+		GameArena = Arena::CreateGrowable();
 		UI::Init(BackBuffer, DefaultFont);
+
+		// nothing here animates, so only redraw for input and the edit cursor
+		RedrawOnDemand = true;
 	}
 
 	~UIExample()
@@ -229,7 +231,7 @@ public:
 		DefaultFont.DrawText(70, 220, HotIDString, 0, BackBuffer);
 		DefaultFont.DrawText(100, 240, ActiveIDString, 0, BackBuffer);
 #endif // DEBUG_UI
-		Jogo::Show(BackBuffer.PixelBGRA, Width, Height);
+		Jogo::Show(BackBuffer);
 	}
 
 	// TODO: handle resizing BackBuffer here
@@ -1,7 +1,9 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "2600.h"
 #include <stdio.h>
+#ifdef _WIN32
 #include <io.h>
+#endif
 
 // CPU 8K Address Space Mirrors(Step 2000h)
 // The 6507 CPU is having only 13 address pins(8KBytes, 0000h - 1FFFh).
@@ -128,12 +130,14 @@ void VCS2600::Init6502()
 {
 	//cpu.load("combat.bin", 0xf000);
 	FILE* fp;
-	fopen_s(&fp, "combat.bin", "rb");
-	unsigned size = (unsigned)_filelength(_fileno(fp));
-	fread(rom, size, 1, fp);
-	if (size == 2048)
-		memcpy(rom + 2048, rom, 2048);
-	fclose(fp);
+	if (!fopen_s(&fp, "combat.bin", "rb"))
+	{
+		unsigned size = (unsigned)_filelength(_fileno(fp));
+		fread(rom, size, 1, fp);
+		if (size == 2048)
+			memcpy(rom + 2048, rom, 2048);
+		fclose(fp);
+	}
 
 	DisassembleRom();
 	cpu.reset(0xf000);
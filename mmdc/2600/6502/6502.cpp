@@ -80,7 +80,9 @@
 
 #include <memory.h>
 #include <stdio.h>
+#ifdef _WIN32
 #include <io.h>
+#endif
 #include "6502.h"
 
 typedef unsigned char byte;
@@ -93,32 +95,32 @@ static const char* zpx = "$%02X,X";
 static const char* zpy = "$%02X,Y";
 static const char* izx = "($%02X,X)";
 static const char* izy = "($%02X),Y";
-static const char* abs = "$%04X";
+static const char* abso = "$%04X";
 static const char* abx = "$%04X,X";
 static const char* aby = "$%04X,Y";
 static const char* ind = "($%04X)";
 static const char* rel = "$%02X";
 
-#define OP(x, len, cycles, fmt) (new CPU6502::instruction(&x, len, cycles, #x, fmt))
+#define OP(x, len, cycles, fmt) (new CPU6502::instruction(&CPU6502::x, len, cycles, #x, fmt))
 CPU6502::instruction* CPU6502::instLookup[] =
 {
 			//x0			x1				x2				x3	x4				x5				x6				x7	x8				x9				xA				xB	xC				xD				xE				xF
-	/*0x*/	OP(BRK,1,7,""),	OP(ORA,2,6,izx),0,				0,	0,				OP(ORA,2,3,zp), OP(ASL,2,5,zp),	0,	OP(PHP,1,3,""),	OP(ORA,2,2,imm),OP(ASL,1,2,acc),0,	0,				OP(ORA,3,4,abs),OP(ASL,3,6,abs),0,
+	/*0x*/	OP(BRK,1,7,""),	OP(ORA,2,6,izx),0,				0,	0,				OP(ORA,2,3,zp), OP(ASL,2,5,zp),	0,	OP(PHP,1,3,""),	OP(ORA,2,2,imm),OP(ASL,1,2,acc),0,	0,				OP(ORA,3,4,abso),OP(ASL,3,6,abso),0,
 	/*1x*/	OP(BPL,2,2,rel),OP(ORA,2,5,izy),0,				0,	0,				OP(ORA,2,4,zpx),OP(ASL,2,6,zpx),0,	OP(CLC,1,2,""),	OP(ORA,3,4,aby),0,				0,	0,				OP(ORA,3,4,abx),OP(ASL,3,7,abx),0,
-	/*2x*/	OP(JSR,3,6,abs),OP(AND,2,6,izx),0,				0,	OP(BIT,2,3,zp), OP(AND,2,3,zp), OP(ROL,2,5,zp),	0,	OP(PLP,1,4,""),	OP(AND,2,2,imm),OP(ROL,1,2,acc),0,	OP(BIT,3,4,abs),OP(AND,3,4,abs),OP(ROL,3,6,abs),0,
+	/*2x*/	OP(JSR,3,6,abso),OP(AND,2,6,izx),0,				0,	OP(BIT,2,3,zp), OP(AND,2,3,zp), OP(ROL,2,5,zp),	0,	OP(PLP,1,4,""),	OP(AND,2,2,imm),OP(ROL,1,2,acc),0,	OP(BIT,3,4,abso),OP(AND,3,4,abso),OP(ROL,3,6,abso),0,
 	/*3x*/	OP(BMI,2,2,rel),OP(AND,2,5,izy),0,				0,	0,				OP(AND,2,4,zpx),OP(ROL,2,6,zpx),0,	OP(SEC,1,2,""),	OP(AND,3,4,aby),0,				0,	0,				OP(AND,3,4,abx),OP(ROL,3,7,abx),0,
-	/*4x*/	OP(RTI,1,6,""),	OP(EOR,2,6,izx),0,				0,	0,				OP(EOR,2,3,zp),	OP(LSR,2,5,zp),	0,	OP(PHA,1,3,""),	OP(EOR,2,2,imm),OP(LSR,1,2,acc),0,	OP(JMP,3,3,abs),OP(EOR,3,4,abs),OP(LSR,3,6,abs),0,
+	/*4x*/	OP(RTI,1,6,""),	OP(EOR,2,6,izx),0,				0,	0,				OP(EOR,2,3,zp),	OP(LSR,2,5,zp),	0,	OP(PHA,1,3,""),	OP(EOR,2,2,imm),OP(LSR,1,2,acc),0,	OP(JMP,3,3,abso),OP(EOR,3,4,abso),OP(LSR,3,6,abso),0,
 	/*5x*/	OP(BVC,2,2,rel),OP(EOR,2,5,izy),0,				0,	0,				OP(EOR,2,4,zpx),OP(LSR,2,6,zpx),0,	OP(CLI,1,2,""),	OP(EOR,3,4,aby),0,				0,	0,				OP(EOR,3,4,abx),OP(LSR,3,7,abx),0,
-	/*6x*/	OP(RTS,1,6,""), OP(ADC,2,6,izx),0,				0,	0,				OP(ADC,2,3,zp), OP(ROR,2,5,zp), 0,	OP(PLA,1,4,""),	OP(ADC,2,2,imm),OP(ROR,1,2,acc),0,	OP(JMP,3,5,ind),OP(ADC,3,4,abs),OP(ROR,3,6,abs),0,
+	/*6x*/	OP(RTS,1,6,""), OP(ADC,2,6,izx),0,				0,	0,				OP(ADC,2,3,zp), OP(ROR,2,5,zp), 0,	OP(PLA,1,4,""),	OP(ADC,2,2,imm),OP(ROR,1,2,acc),0,	OP(JMP,3,5,ind),OP(ADC,3,4,abso),OP(ROR,3,6,abso),0,
 	/*7x*/	OP(BVS,2,2,rel),OP(ADC,2,5,izy),0,				0,	0,				OP(ADC,2,4,zpx),OP(ROR,2,6,zpx),0,	OP(SEI,1,2,""),	OP(ADC,3,4,aby),0,				0,	0,				OP(ADC,3,4,abx),OP(ROR,3,7,abx),0,
 
-	/*8x*/	0,				OP(STA,2,6,izx),0,				0,	OP(STY,2,3,zp), OP(STA,2,3,zp), OP(STX,2,3,zp),	0,	OP(DEY,1,2,""),	0,				OP(TXA,1,2,""),	0,	OP(STY,3,4,abs),OP(STA,3,4,abs),OP(STX,3,4,abs),0,
+	/*8x*/	0,				OP(STA,2,6,izx),0,				0,	OP(STY,2,3,zp), OP(STA,2,3,zp), OP(STX,2,3,zp),	0,	OP(DEY,1,2,""),	0,				OP(TXA,1,2,""),	0,	OP(STY,3,4,abso),OP(STA,3,4,abso),OP(STX,3,4,abso),0,
 	/*9x*/	OP(BCC,2,2,rel),OP(STA,2,6,izy),0,				0,	OP(STY,2,4,zpx),OP(STA,2,4,zpx),OP(STX,2,4,zpy),0,	OP(TYA,1,2,""),	OP(STA,3,5,aby),OP(TXS,1,2,""),	0,	0,				OP(STA,3,5,abx),0,				0,
-	/*Ax*/	OP(LDY,2,2,imm),OP(LDA,2,6,izx),OP(LDX,2,2,imm),0,	OP(LDY,2,3,zp), OP(LDA,2,3,zp),	OP(LDX,2,3,zp),	0,	OP(TAY,1,2,""),	OP(LDA,2,2,imm),OP(TAX,1,2,""),	0,	OP(LDY,3,4,abs),OP(LDA,3,4,abs),OP(LDX,3,4,abs),0,
+	/*Ax*/	OP(LDY,2,2,imm),OP(LDA,2,6,izx),OP(LDX,2,2,imm),0,	OP(LDY,2,3,zp), OP(LDA,2,3,zp),	OP(LDX,2,3,zp),	0,	OP(TAY,1,2,""),	OP(LDA,2,2,imm),OP(TAX,1,2,""),	0,	OP(LDY,3,4,abso),OP(LDA,3,4,abso),OP(LDX,3,4,abso),0,
 	/*Bx*/	OP(BCS,2,2,rel),OP(LDA,2,5,izy),0,				0,	OP(LDY,2,4,zpx),OP(LDA,2,4,zpx),OP(LDX,2,4,zpy),0,	OP(CLV,1,2,""),	OP(LDA,3,4,aby),OP(TSX,1,2,""), 0,	OP(LDY,3,4,abx),OP(LDA,3,4,abx),OP(LDX,3,4,aby),0,
-	/*Cx*/	OP(CPY,2,2,imm),OP(CMP,2,6,izx),0,				0,	OP(CPY,2,3,zp),	OP(CMP,2,3,zp),	OP(DEC,2,5,zp),	0,	OP(INY,1,2,""),	OP(CMP,2,2,imm),OP(DEX,1,2,""), 0,	OP(CPY,3,4,abs),OP(CMP,3,4,abs),OP(DEC,3,6,abs),0,
+	/*Cx*/	OP(CPY,2,2,imm),OP(CMP,2,6,izx),0,				0,	OP(CPY,2,3,zp),	OP(CMP,2,3,zp),	OP(DEC,2,5,zp),	0,	OP(INY,1,2,""),	OP(CMP,2,2,imm),OP(DEX,1,2,""), 0,	OP(CPY,3,4,abso),OP(CMP,3,4,abso),OP(DEC,3,6,abso),0,
 	/*Dx*/	OP(BNE,2,2,rel),OP(CMP,2,6,izy),0,				0,	0,				OP(CMP,2,4,zpx),OP(DEC,2,6,zpx),0,	OP(CLD,1,2,""),	OP(CMP,3,4,aby),0,				0,	0,				OP(CMP,3,4,abx),OP(DEC,3,7,abx),0,
-	/*Ex*/	OP(CPX,2,2,imm),OP(SBC,2,6,izx),0,				0,	OP(CPX,2,3,zp),	OP(SBC,2,3,zp),	OP(INC,2,5,zp),	0,	OP(INX,1,2,""),	OP(SBC,2,2,imm),OP(NOP,1,2,""),	0,	OP(CPX,3,4,abs),OP(SBC,3,4,abs),OP(INC,3,6,abs),0,
+	/*Ex*/	OP(CPX,2,2,imm),OP(SBC,2,6,izx),0,				0,	OP(CPX,2,3,zp),	OP(SBC,2,3,zp),	OP(INC,2,5,zp),	0,	OP(INX,1,2,""),	OP(SBC,2,2,imm),OP(NOP,1,2,""),	0,	OP(CPX,3,4,abso),OP(SBC,3,4,abso),OP(INC,3,6,abso),0,
 	/*Fx*/	OP(BEQ,2,2,rel),OP(SBC,2,5,izy),0,				0,	0,				OP(SBC,2,4,zpx),OP(INC,2,6,zpx),0,	OP(SED,1,2,""),	OP(SBC,3,4,aby),0,				0,	0,				OP(SBC,3,4,abx),OP(INC,3,7,abx),0
 };
 
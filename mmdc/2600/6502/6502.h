@@ -1,6 +1,7 @@
 #include <memory.h>
 #include <string.h>
 #include <stdio.h>
+#include "Platform.h"
 
 typedef unsigned char byte;
 typedef unsigned short ushort;
@@ -294,6 +295,11 @@ struct CPU6502
 	{
 		byte opcode = readByte(pc);
 		instruction* inst = instLookup[opcode];
+		if (inst == 0)
+		{
+			sprintf_s(buffer, maxlen, "??? $%02X", opcode);
+			return 1;
+		}
 		strcpy_s(buffer, maxlen, inst->name);
 		strcat_s(buffer, maxlen, " ");
 		ushort operand = 0;
@@ -1,8 +1,8 @@
 #include "vcs.h"
 
-int tia_colors[];
+extern int tia_colors[];
 typedef unsigned char byte;
-int defaultFrameBuffer[];
+extern int defaultFrameBuffer[];
 
 
 struct TIA
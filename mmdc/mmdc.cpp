@@ -117,7 +117,7 @@ struct MMDC : public Jogo::App
 	MMDC()
 	{
 		vcs2600.Init6502();
-		AtariFont = Font::Load("../Jogo/Atari8Tall.fnt", DefaultArena);
+		AtariFont = Assets.LoadFont("../Jogo/Atari8Tall.fnt", DefaultArena);
 		UI::Init(BackBuffer, AtariFont);
 	}
 
@@ -131,10 +131,11 @@ struct MMDC : public Jogo::App
 
 	void ShowVideo()
 	{
-		Bitmap videoFrame;
+		Bitmap videoFrame = {};
 		videoFrame.Width = 160;
 		videoFrame.Height = 220;
 		videoFrame.PixelSize = 4;
+		videoFrame.Pitch = 160 * 4;
 		videoFrame.Pixels = vcs2600.tia.frameBuffer;
 		BackBuffer.PasteBitmapSelectionScaled({ 0,0,320, 220 }, videoFrame, { 0,0, 160,220 }, 0);
 	}
@@ -251,6 +252,7 @@ struct MMDC : public Jogo::App
 	bool Tick(float dt) override
 	{
 		// handle running/pausing emulator here
+		JOGO_ZONE("VCS2600::runFrame");
 		if (!paused)
 			vcs2600.runFrame();
 		else if (step)
@@ -309,7 +311,10 @@ struct MMDC : public Jogo::App
 		ShowRam();
 		step = step_line = step_frame = false;
 		DoButtons();
-		Show(BackBuffer.PixelBGRA, BackBuffer.Width, BackBuffer.Height);
+		Show(BackBuffer);
+
+		// nothing moves while paused until a key or button steps the emulator
+		RedrawOnDemand = paused;
 
 	}
 